@@ -44,10 +44,23 @@ void eeprom_write_word(uint16_t *addr, uint16_t value) { eeprom_write_block(&val
 void eeprom_write_dword(uint32_t *addr, uint32_t value) { eeprom_write_block(&value, addr, 4); }
 
 void eeprom_update_block(const void *buf, void *addr, size_t len) {
-    uint8_t read_buf[len];
-    eeprom_read_block(read_buf, addr, len);
-    if (memcmp(buf, read_buf, len) != 0) {
-        eeprom_write_block(buf, addr, len);
+    uint8_t        read_buf[EEPROM_DRIVER_PAGE_SIZE];
+    const uint8_t *source      = (const uint8_t *)buf;
+    uintptr_t      target_addr = (uintptr_t)addr;
+    while (len > 0) {
+        size_t chunk_length = EEPROM_DRIVER_PAGE_SIZE - (target_addr % EEPROM_DRIVER_PAGE_SIZE);
+        if (chunk_length > len) {
+            chunk_length = len;
+        }
+
+        eeprom_read_block(read_buf, (const void *)target_addr, chunk_length);
+        if (memcmp(source, read_buf, chunk_length) != 0) {
+            eeprom_write_block(source, (void *)target_addr, chunk_length);
+        }
+
+        source += chunk_length;
+        target_addr += chunk_length;
+        len -= chunk_length;
     }
 }
 
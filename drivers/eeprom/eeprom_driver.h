@@ -18,5 +18,21 @@
 
 #include "eeprom.h"
 
+#if defined(EEPROM_I2C)
+#    include "eeprom_i2c.h"
+#elif defined(EEPROM_SPI)
+#    include "eeprom_spi.h"
+#endif
+
+// eeprom_update_block() compares and writes in chunks that never straddle a device page,
+// so only the pages that actually changed get written
+#ifndef EEPROM_DRIVER_PAGE_SIZE
+#    ifdef EXTERNAL_EEPROM_PAGE_SIZE
+#        define EEPROM_DRIVER_PAGE_SIZE EXTERNAL_EEPROM_PAGE_SIZE
+#    else
+#        define EEPROM_DRIVER_PAGE_SIZE 32
+#    endif
+#endif
+
 void eeprom_driver_init(void);
 void eeprom_driver_erase(void);
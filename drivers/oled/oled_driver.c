@@ -104,6 +104,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 uint8_t         oled_buffer[OLED_MATRIX_SIZE];
 uint8_t *       oled_cursor;
 OLED_BLOCK_TYPE oled_dirty          = 0;
+OLED_BLOCK_TYPE oled_sent           = 0;  // blocks the display has received since init or scrolling
 bool            oled_initialized    = false;
 bool            oled_active         = false;
 bool            oled_scrolling      = false;
@@ -118,6 +119,10 @@ uint32_t oled_timeout;
 #if OLED_SCROLL_TIMEOUT > 0
 uint32_t oled_scroll_timeout;
 #endif
+#ifndef OLED_NO_SHADOW_BUFFER
+// What the display was last sent, so blocks redrawn with the same content aren't sent again
+static uint8_t oled_shadow[OLED_MATRIX_SIZE];
+#endif
 
 // Internal variables to reduce math instructions
 
@@ -206,6 +211,7 @@ bool oled_init(uint8_t rotation) {
     oled_scroll_timeout = timer_read32() + OLED_SCROLL_TIMEOUT;
 #endif
 
+    oled_sent = 0;
     oled_clear();
     oled_initialized = true;
     oled_active      = true;
@@ -216,9 +222,19 @@ bool oled_init(uint8_t rotation) {
 __attribute__((weak)) oled_rotation_t oled_init_user(oled_rotation_t rotation) { return rotation; }
 
 void oled_clear(void) {
-    memset(oled_buffer, 0, sizeof(oled_buffer));
+    // Only blocks that held something need to be sent again
+    for (uint8_t block = 0; block < OLED_BLOCK_COUNT; ++block) {
+        uint8_t *data = &oled_buffer[OLED_BLOCK_SIZE * block];
+        for (uint16_t i = 0; i < OLED_BLOCK_SIZE; ++i) {
+            if (data[i]) {
+                memset(data, 0, OLED_BLOCK_SIZE);
+                oled_dirty |= ((OLED_BLOCK_TYPE)1 << block);
+                break;
+            }
+        }
+    }
+    oled_dirty |= ~oled_sent & OLED_ALL_BLOCKS_MASK;
     oled_cursor = &oled_buffer[0];
-    oled_dirty  = OLED_ALL_BLOCKS_MASK;
 }
 
 static void calc_bounds(uint8_t update_start, uint8_t *cmd_array) {
@@ -266,19 +282,7 @@ static void rotate_90(const uint8_t *src, uint8_t *dest) {
     }
 }
 
-void oled_render(void) {
-    // Do we have work to do?
-    oled_dirty &= OLED_ALL_BLOCKS_MASK;
-    if (!oled_dirty || oled_scrolling) {
-        return;
-    }
-
-    // Find first dirty block
-    uint8_t update_start = 0;
-    while (!(oled_dirty & ((OLED_BLOCK_TYPE)1 << update_start))) {
-        ++update_start;
-    }
-
+static bool oled_render_block(uint8_t update_start) {
     // Set column & page position
     static uint8_t display_start[] = {I2C_CMD, COLUMN_ADDR, 0, OLED_DISPLAY_WIDTH - 1, PAGE_ADDR, 0, OLED_DISPLAY_HEIGHT / 8 - 1};
     if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
@@ -290,14 +294,14 @@ void oled_render(void) {
     // Send column & page position
     if (I2C_TRANSMIT(display_start) != I2C_STATUS_SUCCESS) {
         print("oled_render offset command failed\n");
-        return;
+        return false;
     }
 
     if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
         // Send render data chunk as is
         if (I2C_WRITE_REG(I2C_DATA, &oled_buffer[OLED_BLOCK_SIZE * update_start], OLED_BLOCK_SIZE) != I2C_STATUS_SUCCESS) {
             print("oled_render data failed\n");
-            return;
+            return false;
         }
     } else {
         // Rotate the render chunks
@@ -313,15 +317,58 @@ void oled_render(void) {
         // Send render data chunk after rotating
         if (I2C_WRITE_REG(I2C_DATA, &temp_buffer[0], OLED_BLOCK_SIZE) != I2C_STATUS_SUCCESS) {
             print("oled_render90 data failed\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void oled_render(void) {
+    // Do we have work to do?
+    oled_dirty &= OLED_ALL_BLOCKS_MASK;
+    if (!oled_dirty || oled_scrolling) {
+        return;
+    }
+
+    // Send dirty blocks in order until the byte budget for this call is spent
+    uint16_t sent = 0;
+    for (uint8_t block = 0; block < OLED_BLOCK_COUNT && oled_dirty; ++block) {
+        OLED_BLOCK_TYPE mask = (OLED_BLOCK_TYPE)1 << block;
+        if (!(oled_dirty & mask)) {
+            continue;
+        }
+
+#ifndef OLED_NO_SHADOW_BUFFER
+        // Clearing and redrawing every frame marks blocks dirty without changing them
+        if ((oled_sent & mask) && memcmp(&oled_buffer[OLED_BLOCK_SIZE * block], &oled_shadow[OLED_BLOCK_SIZE * block], OLED_BLOCK_SIZE) == 0) {
+            oled_dirty &= ~mask;
+            continue;
+        }
+#endif
+
+        if (sent && sent + OLED_BLOCK_SIZE > OLED_UPDATE_BUDGET) {
+            break;
+        }
+
+        if (!oled_render_block(block)) {
+            oled_sent &= ~mask;
             return;
         }
+#ifndef OLED_NO_SHADOW_BUFFER
+        memcpy(&oled_shadow[OLED_BLOCK_SIZE * block], &oled_buffer[OLED_BLOCK_SIZE * block], OLED_BLOCK_SIZE);
+#endif
+
+        // Clear dirty flag
+        oled_dirty &= ~mask;
+        oled_sent |= mask;
+        sent += OLED_BLOCK_SIZE;
     }
 
     // Turn on display if it is off
-    oled_on();
-
-    // Clear dirty flag
-    oled_dirty &= ~((OLED_BLOCK_TYPE)1 << update_start);
+    if (sent) {
+        oled_on();
+    }
 }
 
 void oled_set_cursor(uint8_t col, uint8_t line) {
@@ -612,6 +659,7 @@ bool oled_scroll_off(void) {
         }
         oled_scrolling = false;
         oled_dirty     = OLED_ALL_BLOCKS_MASK;
+        oled_sent      = 0;  // scrolling shifted the display memory
     }
     return !oled_scrolling;
 }
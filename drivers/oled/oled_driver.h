@@ -154,6 +154,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    define OLED_I2C_TIMEOUT 100
 #endif
 
+// Maximum number of bytes oled_render sends per call, at least one block is always sent
+#if !defined(OLED_UPDATE_BUDGET)
+#    define OLED_UPDATE_BUDGET OLED_BLOCK_SIZE
+#endif
+
 typedef struct __attribute__((__packed__)) {
     uint8_t *current_element;
     uint16_t remaining_element_count;
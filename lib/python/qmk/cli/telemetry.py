@@ -0,0 +1,131 @@
+"""Stream and decode the binary telemetry sent by keyboards built with TELEMETRY_ENABLE.
+"""
+import json
+import time
+
+from milc import cli
+
+from qmk.telemetry import PACKET_SIZE, TelemetryState, start_command, stop_command
+
+# Usage page and usage of the QMK raw HID interface
+RAW_USAGE_PAGE = 0xFF60
+RAW_USAGE_ID = 0x61
+
+
+def _print_state(state):
+    """Print one interval, as JSON when asked to.
+    """
+    if cli.args.json:
+        print(json.dumps(state.as_dict()), flush=True)
+        return
+
+    loop_time = ' '.join('%s:%d' % bucket for bucket in state.loop_time.items() if bucket[1])
+    cli.echo('{fg_cyan}%8.1fs{style_reset_all} scan %5s/s  layers %s/%s  loop %s', (state.uptime or 0) / 1000, state.scan_rate, _hex(state.layer_state), _hex(state.default_layer_state), loop_time)
+    if state.reports:
+        cli.echo('          reports %s', ' '.join('%s:%d' % item for item in state.reports.items()))
+    cli.echo('          split errors %s  eeprom %s  dropped packets %d', state.split_errors, ' '.join('%s:%d' % item for item in state.eeprom_writes.items() if item[1]) or 0, state.dropped)
+
+
+def _hex(value):
+    """Layer states in hex, or - if they haven't been reported yet.
+    """
+    return '-' if value is None else '%X' % value
+
+
+def _decode_file(filename):
+    """Decode a capture of raw HID packets, PACKET_SIZE bytes each.
+    """
+    state = TelemetryState()
+    with open(filename, 'rb') as capture:
+        while True:
+            packet = capture.read(PACKET_SIZE)
+            if len(packet) < PACKET_SIZE:
+                break
+            if state.update(packet):
+                _print_state(state)
+
+
+def _find_device(device_id):
+    """Returns the first raw HID interface, of the given (VID, PID) if there is one.
+    """
+    import hid
+
+    for device in hid.enumerate():
+        if device_id and (device['vendor_id'], device['product_id']) != device_id:
+            continue
+        if device['usage_page'] == RAW_USAGE_PAGE and device['usage'] == RAW_USAGE_ID:
+            return device
+    return None
+
+
+def _stream(device_id, interval, capture):
+    """Keep the stream running and print each update until interrupted.
+    """
+    import hid
+
+    info = _find_device(device_id)
+    if not info:
+        cli.log.error('No raw HID interface found. Is the keyboard connected and built with TELEMETRY_ENABLE?')
+        return False
+
+    cli.log.info('Streaming telemetry from {fg_cyan}%s %s{style_reset_all}, press Ctrl-C to stop.', info['manufacturer_string'], info['product_string'])
+    device = hid.device()
+    device.open_path(info['path'])
+    state = TelemetryState()
+    # The keyboard stops streaming if it isn't asked again within a few seconds
+    renewed = 0
+
+    try:
+        while True:
+            if time.monotonic() - renewed > 1:
+                # hidapi wants the report ID first, raw HID doesn't use one
+                device.write(b'\x00' + start_command(interval))
+                renewed = time.monotonic()
+
+            packet = bytes(device.read(PACKET_SIZE, 100))
+            if not packet:
+                continue
+            if capture:
+                capture.write(packet)
+            if state.update(packet):
+                _print_state(state)
+
+    except KeyboardInterrupt:
+        pass
+
+    finally:
+        device.write(b'\x00' + stop_command())
+        device.close()
+
+    return True
+
+
+@cli.argument('-d', '--device', help='VID:PID of the keyboard, in hex. Defaults to the first keyboard with a raw HID interface.')
+@cli.argument('-i', '--interval', type=int, default=0, help='Milliseconds between updates. Defaults to the keyboard\'s TELEMETRY_INTERVAL.')
+@cli.argument('-f', '--file', arg_only=True, help='Decode a capture instead of a connected keyboard.')
+@cli.argument('-o', '--output', arg_only=True, help='Also save the raw packets to this file, for decoding later with --file.')
+@cli.argument('--json', arg_only=True, action='store_true', help='Print each update as a line of JSON.')
+@cli.subcommand('Stream and decode telemetry from a keyboard built with TELEMETRY_ENABLE.')
+def telemetry(cli):
+    """Show the scan rate, loop times, layers, report counts, split errors and EEPROM writes of a running keyboard.
+    """
+    if cli.args.file:
+        _decode_file(cli.args.file)
+        return True
+
+    try:
+        import hid  # noqa: F401
+    except ImportError:
+        cli.log.error('Streaming needs the hidapi package, install it with: {fg_cyan}python3 -m pip install hidapi')
+        return False
+
+    device_id = None
+    if cli.config.telemetry.device:
+        vid, pid = cli.config.telemetry.device.split(':')
+        device_id = (int(vid, 16), int(pid, 16))
+
+    if cli.args.output:
+        with open(cli.args.output, 'wb') as capture:
+            return _stream(device_id, cli.config.telemetry.interval, capture)
+
+    return _stream(device_id, cli.config.telemetry.interval, None)
@@ -0,0 +1,144 @@
+"""Decoder for the binary telemetry stream sent over raw HID by quantum/telemetry.c.
+"""
+import struct
+
+PACKET_ID = 0xFE
+PACKET_SIZE = 32
+RECORD_SIZE = 6
+LOOP_BUCKETS = 8
+VERSION = 1
+
+CMD_START = 0x01
+CMD_STOP = 0x02
+
+TAG_HELLO = 0x01
+TAG_UPTIME = 0x02
+TAG_SCAN_RATE = 0x03
+TAG_LOOP_TIME = 0x04
+TAG_LAYER = 0x05
+TAG_REPORTS = 0x06
+TAG_SPLIT_ERRORS = 0x07
+TAG_EEPROM_WRITES = 0x08
+TAG_INTERVAL_END = 0x09
+
+# Field order of host_report_stats_t
+REPORT_FIELDS = ('keyboard_sent', 'keyboard_suppressed', 'system_sent', 'system_suppressed', 'consumer_sent', 'consumer_suppressed')
+
+# Order of enum eeprom_profile_region, offset by one in the record index
+EEPROM_REGIONS = ('deferred_flushes', 'eeconfig', 'rgblight', 'rgb_matrix', 'via', 'dynamic_keymap', 'macro', 'other')
+
+
+def start_command(interval=0):
+    """Returns the packet that starts the stream, or keeps it running. An interval of 0 uses the keyboard's default.
+    """
+    return bytes([PACKET_ID, CMD_START]) + struct.pack('<H', interval) + bytes(PACKET_SIZE - 4)
+
+
+def stop_command():
+    """Returns the packet that stops the stream.
+    """
+    return bytes([PACKET_ID, CMD_STOP]) + bytes(PACKET_SIZE - 2)
+
+
+def decode_packet(packet):
+    """Split a packet into its sequence number and a list of (tag, index, value) records.
+
+    Returns None for packets that aren't telemetry, such as VIA replies.
+    """
+    if len(packet) < 2 or packet[0] != PACKET_ID:
+        return None
+
+    records = []
+    for offset in range(2, len(packet) - RECORD_SIZE + 1, RECORD_SIZE):
+        tag, index, value = struct.unpack_from('<BBI', packet, offset)
+        if not tag:
+            break
+        records.append((tag, index, value))
+
+    return packet[1], records
+
+
+def loop_bucket_name(index):
+    """Human readable range of a loop time histogram bucket.
+    """
+    if index == 0:
+        return '<1ms'
+    low = 1 << (index - 1)
+    high = (low << 1) - 1
+    if index == LOOP_BUCKETS - 1:
+        return '>=%dms' % low
+    if low == high:
+        return '%dms' % low
+    return '%d-%dms' % (low, high)
+
+
+class TelemetryState:
+    """Keeps the latest value of everything the keyboard has reported.
+    """
+    def __init__(self):
+        self.version = None
+        self.interval = None
+        self.uptime = None
+        self.scan_rate = None
+        self.loop_time = {}
+        self.layer_state = None
+        self.default_layer_state = None
+        self.reports = {}
+        self.split_errors = None
+        self.eeprom_writes = {}
+        self.sequence = None
+        self.dropped = 0
+
+    def update(self, packet):
+        """Apply a packet. Returns True when it completed an interval.
+        """
+        decoded = decode_packet(packet)
+        if decoded is None:
+            return False
+
+        sequence, records = decoded
+        if self.sequence is not None:
+            self.dropped += (sequence - self.sequence - 1) & 0xFF
+        self.sequence = sequence
+
+        complete = False
+        for tag, index, value in records:
+            if tag == TAG_HELLO:
+                self.version = index
+                self.interval = value
+            elif tag == TAG_UPTIME:
+                self.uptime = value
+            elif tag == TAG_SCAN_RATE:
+                self.scan_rate = value
+            elif tag == TAG_LOOP_TIME:
+                self.loop_time[loop_bucket_name(index)] = value
+            elif tag == TAG_LAYER:
+                if index == 0:
+                    self.layer_state = value
+                else:
+                    self.default_layer_state = value
+            elif tag == TAG_REPORTS:
+                self.reports[REPORT_FIELDS[index] if index < len(REPORT_FIELDS) else str(index)] = value
+            elif tag == TAG_SPLIT_ERRORS:
+                self.split_errors = value
+            elif tag == TAG_EEPROM_WRITES:
+                self.eeprom_writes[EEPROM_REGIONS[index] if index < len(EEPROM_REGIONS) else str(index)] = value
+            elif tag == TAG_INTERVAL_END:
+                complete = True
+
+        return complete
+
+    def as_dict(self):
+        """Everything known so far, for JSON output.
+        """
+        return {
+            'uptime': self.uptime,
+            'scan_rate': self.scan_rate,
+            'loop_time': self.loop_time,
+            'layer_state': self.layer_state,
+            'default_layer_state': self.default_layer_state,
+            'reports': self.reports,
+            'split_errors': self.split_errors,
+            'eeprom_writes': self.eeprom_writes,
+            'dropped_packets': self.dropped,
+        }
@@ -67,12 +67,12 @@ void process_api(uint16_t length, uint8_t* data) {
                     break;
                 }
                 case DT_DEBUG: {
-                    uint8_t debug_bytes[1] = {eeprom_read_byte(EECONFIG_DEBUG)};
+                    uint8_t debug_bytes[1] = {eeconfig_read_byte(EECONFIG_DEBUG)};
                     MT_GET_DATA_ACK(DT_DEBUG, debug_bytes, 1);
                     break;
                 }
                 case DT_DEFAULT_LAYER: {
-                    uint8_t default_bytes[1] = {eeprom_read_byte(EECONFIG_DEFAULT_LAYER)};
+                    uint8_t default_bytes[1] = {eeconfig_read_byte(EECONFIG_DEFAULT_LAYER)};
                     MT_GET_DATA_ACK(DT_DEFAULT_LAYER, default_bytes, 1);
                     break;
                 }
@@ -84,7 +84,7 @@ void process_api(uint16_t length, uint8_t* data) {
                 }
                 case DT_AUDIO: {
 #ifdef AUDIO_ENABLE
-                    uint8_t audio_bytes[1] = {eeprom_read_byte(EECONFIG_AUDIO)};
+                    uint8_t audio_bytes[1] = {eeconfig_read_byte(EECONFIG_AUDIO)};
                     MT_GET_DATA_ACK(DT_AUDIO, audio_bytes, 1);
 #else
                     MT_GET_DATA_ACK(DT_AUDIO, NULL, 0);
@@ -93,7 +93,7 @@ void process_api(uint16_t length, uint8_t* data) {
                 }
                 case DT_BACKLIGHT: {
 #ifdef BACKLIGHT_ENABLE
-                    uint8_t backlight_bytes[1] = {eeprom_read_byte(EECONFIG_BACKLIGHT)};
+                    uint8_t backlight_bytes[1] = {eeconfig_read_byte(EECONFIG_BACKLIGHT)};
                     MT_GET_DATA_ACK(DT_BACKLIGHT, backlight_bytes, 1);
 #else
                     MT_GET_DATA_ACK(DT_BACKLIGHT, NULL, 0);
@@ -18,7 +18,7 @@
 #include "led_tables.h"
 #include "progmem.h"
 
-RGB hsv_to_rgb_impl(HSV hsv, bool use_cie) {
+static inline RGB hsv_to_rgb_impl(HSV hsv, bool use_cie) {
     RGB      rgb;
     uint8_t  region, remainder, p, q, t;
     uint16_t h, s, v;
@@ -52,7 +52,8 @@ RGB hsv_to_rgb_impl(HSV hsv, bool use_cie) {
     v = hsv.v;
 #endif
 
-    region    = h * 6 / 255;
+    // h * 6 / 255 without a division, exact for the whole hue range
+    region    = (h * 6 + 1 + ((h * 6) >> 8)) >> 8;
     remainder = (h * 2 - region * 85) * 3;
 
     p = (v * (255 - s)) >> 8;
@@ -97,7 +98,8 @@ RGB hsv_to_rgb_impl(HSV hsv, bool use_cie) {
 }
 
 RGB hsv_to_rgb(HSV hsv) {
-#ifdef USE_CIE1931_CURVE
+// With output gamma correction the curve is applied per channel on flush instead
+#if defined(USE_CIE1931_CURVE) && !defined(RGB_GAMMA_CORRECTION)
     return hsv_to_rgb_impl(hsv, true);
 #else
     return hsv_to_rgb_impl(hsv, false);
@@ -106,6 +108,32 @@ RGB hsv_to_rgb(HSV hsv) {
 
 RGB hsv_to_rgb_nocie(HSV hsv) { return hsv_to_rgb_impl(hsv, false); }
 
+void hsv_to_rgb_batch(const HSV *hsv, RGB *rgb, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+#if defined(USE_CIE1931_CURVE) && !defined(RGB_GAMMA_CORRECTION)
+        rgb[i] = hsv_to_rgb_impl(hsv[i], true);
+#else
+        rgb[i] = hsv_to_rgb_impl(hsv[i], false);
+#endif
+    }
+}
+
+#ifdef RGB_GAMMA_CORRECTION
+uint8_t rgb_gamma_correct(uint8_t value) { return pgm_read_byte(&CIE1931_CURVE[value]); }
+#endif
+
+/* Returns the factor (256 = unscaled) that brings a frame with the given sum
+ * of channel values within a budget in mA, assuming RGB_CHANNEL_CURRENT mA per
+ * channel at full brightness. A budget of 0 disables the limit.
+ */
+uint16_t rgb_power_limit_scale(uint32_t channel_sum, uint16_t budget) {
+    uint32_t limit = (uint32_t)budget * UINT8_MAX / RGB_CHANNEL_CURRENT;
+    if (!budget || channel_sum <= limit) {
+        return 256;
+    }
+    return (limit << 8) / channel_sum;
+}
+
 #ifdef RGBW
 #    ifndef MIN
 #        define MIN(a, b) ((a) < (b) ? (a) : (b))
@@ -65,6 +65,17 @@ typedef struct PACKED {
 
 RGB hsv_to_rgb(HSV hsv);
 RGB hsv_to_rgb_nocie(HSV hsv);
+// Converts count colors in one pass, same result as calling hsv_to_rgb() on each
+void hsv_to_rgb_batch(const HSV *hsv, RGB *rgb, uint8_t count);
+
+// Output post-processing, applied once per frame right before the driver write
+#ifndef RGB_CHANNEL_CURRENT
+#    define RGB_CHANNEL_CURRENT 20  // mA drawn by a single channel at full brightness
+#endif
+#ifdef RGB_GAMMA_CORRECTION
+uint8_t rgb_gamma_correct(uint8_t value);
+#endif
+uint16_t rgb_power_limit_scale(uint32_t channel_sum, uint16_t budget);
 #ifdef RGBW
 void convert_rgb_to_rgbw(LED_TYPE *led);
 #endif
@@ -21,6 +21,12 @@
 #include "quantum.h"  // for send_string()
 #include "dynamic_keymap.h"
 #include "via.h"  // for default VIA_EEPROM_ADDR_END
+#include "timer.h"
+#include <string.h>
+
+#ifdef EEPROM_PROFILE_ENABLE
+#    include "eeprom_profile.h"
+#endif
 
 #ifndef DYNAMIC_KEYMAP_LAYER_COUNT
 #    define DYNAMIC_KEYMAP_LAYER_COUNT 4
@@ -57,9 +63,49 @@
 #    endif
 #endif
 
+// Most macro actions (a character, or a tap, down or up code) played back per call to dynamic_keymap_task()
+#ifndef DYNAMIC_KEYMAP_MACRO_ACTIONS_PER_TASK
+#    define DYNAMIC_KEYMAP_MACRO_ACTIONS_PER_TASK 1
+#endif
+
+// Macros that can be waiting to play while another one is playing
+#ifndef DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE
+#    define DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE 4
+#endif
+
+#define DYNAMIC_KEYMAP_LAYER_KEYS (MATRIX_ROWS * MATRIX_COLS)
+#define DYNAMIC_KEYMAP_KEY_COUNT (DYNAMIC_KEYMAP_LAYER_COUNT * DYNAMIC_KEYMAP_LAYER_KEYS)
+
+#ifdef DYNAMIC_KEYMAP_SPARSE
+#    ifdef DYNAMIC_KEYMAP_RAM_MIRROR
+#        error DYNAMIC_KEYMAP_SPARSE and DYNAMIC_KEYMAP_RAM_MIRROR cannot be used together
+#    endif
+
+// Most keycodes stored across all layers, transparent keys take no space
+#    ifndef DYNAMIC_KEYMAP_SPARSE_KEY_COUNT
+#        define DYNAMIC_KEYMAP_SPARSE_KEY_COUNT (4 * DYNAMIC_KEYMAP_LAYER_KEYS)
+#    endif
+
+// Entries in the RAM cache of decoded keycodes
+#    ifndef DYNAMIC_KEYMAP_SPARSE_CACHE_SIZE
+#        define DYNAMIC_KEYMAP_SPARSE_CACHE_SIZE 32
+#    endif
+
+// Each layer has a bitmap of its non-transparent keys, followed by a pool
+// of their keycodes packed in layer/row/column order, then a byte holding
+// the first layer being rewritten while the pool is moved, or 0xFF
+#    define DYNAMIC_KEYMAP_BITMAP_SIZE ((DYNAMIC_KEYMAP_LAYER_KEYS + 7) / 8)
+#    define DYNAMIC_KEYMAP_POOL_EEPROM_ADDR (DYNAMIC_KEYMAP_EEPROM_ADDR + DYNAMIC_KEYMAP_LAYER_COUNT * DYNAMIC_KEYMAP_BITMAP_SIZE)
+#    define DYNAMIC_KEYMAP_PENDING_EEPROM_ADDR (DYNAMIC_KEYMAP_POOL_EEPROM_ADDR + DYNAMIC_KEYMAP_SPARSE_KEY_COUNT * 2)
+#    define DYNAMIC_KEYMAP_EEPROM_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * DYNAMIC_KEYMAP_BITMAP_SIZE + DYNAMIC_KEYMAP_SPARSE_KEY_COUNT * 2 + 1)
+#    define DYNAMIC_KEYMAP_NONE_PENDING 0xFF
+#else
+#    define DYNAMIC_KEYMAP_EEPROM_SIZE (DYNAMIC_KEYMAP_KEY_COUNT * 2)
+#endif
+
 // Dynamic macro starts after dynamic keymaps
 #ifndef DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR
-#    define DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR (DYNAMIC_KEYMAP_EEPROM_ADDR + (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2))
+#    define DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR (DYNAMIC_KEYMAP_EEPROM_ADDR + DYNAMIC_KEYMAP_EEPROM_SIZE)
 #endif
 
 // Sanity check that dynamic keymaps fit in available EEPROM
@@ -77,32 +123,450 @@
 #    define DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR - DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + 1)
 #endif
 
+#ifdef DYNAMIC_KEYMAP_RAM_MIRROR
+// How long the keymap must be left alone before changed keycodes are written back to EEPROM
+#    ifndef DYNAMIC_KEYMAP_WRITE_BACK_DELAY
+#        define DYNAMIC_KEYMAP_WRITE_BACK_DELAY 1000
+#    endif
+
+// Most changed keycodes written back per call to dynamic_keymap_task(),
+// as a single block of adjacent keycodes
+#    ifndef DYNAMIC_KEYMAP_WRITE_BACK_KEYS
+#        define DYNAMIC_KEYMAP_WRITE_BACK_KEYS 16
+#    endif
+
+// Keycodes in native byte order, indexed the same way as the EEPROM buffer
+static uint16_t dynamic_keymap_mirror[DYNAMIC_KEYMAP_KEY_COUNT];
+static uint8_t  dynamic_keymap_dirty[(DYNAMIC_KEYMAP_KEY_COUNT + 7) / 8];
+static uint16_t dynamic_keymap_dirty_count   = 0;
+static uint16_t dynamic_keymap_dirty_timer   = 0;
+static uint16_t dynamic_keymap_dirty_next    = 0;
+static bool     dynamic_keymap_mirror_loaded = false;
+#endif
+
+#ifdef DYNAMIC_KEYMAP_SPARSE
+// Pool slot of the first keycode of each layer, the last entry is the number of slots in use
+static uint16_t dynamic_keymap_layer_start[DYNAMIC_KEYMAP_LAYER_COUNT + 1];
+// Direct mapped cache of decoded keycodes, tagged with the key index
+static uint16_t dynamic_keymap_cache_index[DYNAMIC_KEYMAP_SPARSE_CACHE_SIZE];
+static uint16_t dynamic_keymap_cache_keycode[DYNAMIC_KEYMAP_SPARSE_CACHE_SIZE];
+static bool     dynamic_keymap_sparse_loaded = false;
+#endif
+
+// Offset of each macro in the macro buffer, built on first use and dropped whenever the buffer changes
+static uint16_t dynamic_keymap_macro_offsets[DYNAMIC_KEYMAP_MACRO_COUNT];
+static bool     dynamic_keymap_macro_indexed = false;
+
+// Macro being played back, read from EEPROM a chunk at a time
+static struct {
+    uint16_t offset;
+    uint8_t  buffer[32];
+    uint8_t  head;
+    uint8_t  length;
+    bool     active;
+    uint8_t  queue[DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE];
+    uint8_t  queue_count;
+} dynamic_keymap_macro_play;
+
 uint8_t dynamic_keymap_get_layer_count(void) { return DYNAMIC_KEYMAP_LAYER_COUNT; }
 
+#ifdef EEPROM_PROFILE_ENABLE
+uint8_t eeprom_profile_dynamic_keymap_region(uintptr_t addr) {
+    if (addr >= VIA_EEPROM_MAGIC_ADDR && addr < DYNAMIC_KEYMAP_EEPROM_ADDR) {
+        return EEPROM_PROFILE_VIA;
+    } else if (addr >= DYNAMIC_KEYMAP_EEPROM_ADDR && addr < DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR) {
+        return EEPROM_PROFILE_DYNAMIC_KEYMAP;
+    } else if (addr >= DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR && addr < DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
+        return EEPROM_PROFILE_MACRO;
+    }
+    return EEPROM_PROFILE_OTHER;
+}
+#endif
+
+#ifndef DYNAMIC_KEYMAP_SPARSE
 void *dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t column) {
     // TODO: optimize this with some left shifts
     return ((void *)DYNAMIC_KEYMAP_EEPROM_ADDR) + (layer * MATRIX_ROWS * MATRIX_COLS * 2) + (row * MATRIX_COLS * 2) + (column * 2);
 }
+#endif
 
-uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column) {
-    void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
+// Reads size bytes of the EEPROM region starting at offset, zero filling past its end
+static void dynamic_keymap_read_buffer(void *base, uint16_t region_size, uint16_t offset, uint16_t size, uint8_t *data) {
+    uint16_t length = offset < region_size ? region_size - offset : 0;
+    if (length > size) {
+        length = size;
+    }
+    eeprom_read_block(data, base + offset, length);
+    memset(data + length, 0x00, size - length);
+}
+
+// Updates size bytes of the EEPROM region starting at offset, dropping anything past its end
+static void dynamic_keymap_update_buffer(void *base, uint16_t region_size, uint16_t offset, uint16_t size, const uint8_t *data) {
+    uint16_t length = offset < region_size ? region_size - offset : 0;
+    if (length > size) {
+        length = size;
+    }
+    eeprom_update_block(data, base + offset, length);
+}
+
+#if !defined(DYNAMIC_KEYMAP_RAM_MIRROR) && !defined(DYNAMIC_KEYMAP_SPARSE)
+static uint16_t dynamic_keymap_read_keycode(void *address) {
     // Big endian, so we can read/write EEPROM directly from host if we want
-    uint16_t keycode = eeprom_read_byte(address) << 8;
-    keycode |= eeprom_read_byte(address + 1);
-    return keycode;
+    uint8_t data[2];
+    eeprom_read_block(data, address, 2);
+    return (data[0] << 8) | data[1];
 }
 
-void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode) {
-    void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
+static void dynamic_keymap_write_keycode(void *address, uint16_t keycode) {
     // Big endian, so we can read/write EEPROM directly from host if we want
-    eeprom_update_byte(address, (uint8_t)(keycode >> 8));
-    eeprom_update_byte(address + 1, (uint8_t)(keycode & 0xFF));
+    uint8_t data[2] = {(uint8_t)(keycode >> 8), (uint8_t)(keycode & 0xFF)};
+    eeprom_update_block(data, address, 2);
+}
+#endif
+
+#ifdef DYNAMIC_KEYMAP_RAM_MIRROR
+static void dynamic_keymap_mirror_load(void) {
+    // Read the whole keymap in one go, then swap from big endian in place
+    eeprom_read_block(dynamic_keymap_mirror, (void *)DYNAMIC_KEYMAP_EEPROM_ADDR, sizeof(dynamic_keymap_mirror));
+    for (uint16_t i = 0; i < DYNAMIC_KEYMAP_KEY_COUNT; i++) {
+        uint8_t *data            = (uint8_t *)&dynamic_keymap_mirror[i];
+        dynamic_keymap_mirror[i] = (data[0] << 8) | data[1];
+    }
+    memset(dynamic_keymap_dirty, 0, sizeof(dynamic_keymap_dirty));
+    dynamic_keymap_dirty_count   = 0;
+    dynamic_keymap_mirror_loaded = true;
+}
+
+static void dynamic_keymap_mirror_set(uint16_t index, uint16_t keycode) {
+    if (!dynamic_keymap_mirror_loaded) {
+        dynamic_keymap_mirror_load();
+    }
+    // Every write restarts the quiet period, so a burst of writes from the host
+    // is coalesced into a single pass over the changed keycodes
+    dynamic_keymap_dirty_timer = timer_read();
+    if (dynamic_keymap_mirror[index] == keycode) {
+        return;
+    }
+    dynamic_keymap_mirror[index] = keycode;
+    if (!(dynamic_keymap_dirty[index / 8] & (1 << (index % 8)))) {
+        dynamic_keymap_dirty[index / 8] |= 1 << (index % 8);
+        dynamic_keymap_dirty_count++;
+    }
+}
+
+// Writes back the run of adjacent changed keycodes at or after dynamic_keymap_dirty_next
+static void dynamic_keymap_write_back_next(void) {
+    uint8_t  data[DYNAMIC_KEYMAP_WRITE_BACK_KEYS * 2];
+    uint16_t index = dynamic_keymap_dirty_next;
+    while (!(dynamic_keymap_dirty[index / 8] & (1 << (index % 8)))) {
+        if (++index >= DYNAMIC_KEYMAP_KEY_COUNT) {
+            index = 0;
+        }
+    }
+
+    uint16_t start = index;
+    uint8_t  count = 0;
+    while (count < DYNAMIC_KEYMAP_WRITE_BACK_KEYS && index < DYNAMIC_KEYMAP_KEY_COUNT && (dynamic_keymap_dirty[index / 8] & (1 << (index % 8)))) {
+        dynamic_keymap_dirty[index / 8] &= ~(1 << (index % 8));
+        dynamic_keymap_dirty_count--;
+        data[count * 2]     = (uint8_t)(dynamic_keymap_mirror[index] >> 8);
+        data[count * 2 + 1] = (uint8_t)(dynamic_keymap_mirror[index] & 0xFF);
+        count++;
+        index++;
+    }
+    eeprom_update_block(data, (void *)DYNAMIC_KEYMAP_EEPROM_ADDR + start * 2, count * 2);
+    dynamic_keymap_dirty_next = index < DYNAMIC_KEYMAP_KEY_COUNT ? index : 0;
+}
+#endif
+
+#ifdef DYNAMIC_KEYMAP_SPARSE
+static uint8_t dynamic_keymap_popcount(uint8_t bits) {
+    uint8_t count = 0;
+    while (bits) {
+        bits &= bits - 1;
+        count++;
+    }
+    return count;
+}
+
+// Works out where each layer starts in the pool from the layer bitmaps
+static void dynamic_keymap_sparse_count(void) {
+    uint8_t  bitmap[DYNAMIC_KEYMAP_BITMAP_SIZE];
+    uint16_t slot = 0;
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        dynamic_keymap_layer_start[layer] = slot;
+        eeprom_read_block(bitmap, (void *)DYNAMIC_KEYMAP_EEPROM_ADDR + layer * DYNAMIC_KEYMAP_BITMAP_SIZE, DYNAMIC_KEYMAP_BITMAP_SIZE);
+        for (uint8_t i = 0; i < DYNAMIC_KEYMAP_BITMAP_SIZE; i++) {
+            slot += dynamic_keymap_popcount(bitmap[i]);
+        }
+    }
+    dynamic_keymap_layer_start[DYNAMIC_KEYMAP_LAYER_COUNT] = slot;
+}
+
+// Rebuilds the layers from first onwards from flash in one pass, appending to the pool so nothing
+// has to be shifted. The layers are marked pending throughout, so an interrupted reset is redone.
+static void dynamic_keymap_sparse_reset(uint8_t first) {
+    dynamic_keymap_sparse_count();
+    uint16_t slot = dynamic_keymap_layer_start[first];
+    eeprom_update_byte((uint8_t *)DYNAMIC_KEYMAP_PENDING_EEPROM_ADDR, first);
+    for (uint8_t layer = first; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        uint8_t bitmap[DYNAMIC_KEYMAP_BITMAP_SIZE] = {0};
+        dynamic_keymap_layer_start[layer]          = slot;
+        for (uint16_t key = 0; key < DYNAMIC_KEYMAP_LAYER_KEYS; key++) {
+            uint16_t keycode = pgm_read_word(&keymaps[layer][key / MATRIX_COLS][key % MATRIX_COLS]);
+            if (keycode == KC_TRNS || slot >= DYNAMIC_KEYMAP_SPARSE_KEY_COUNT) {
+                continue;
+            }
+            uint8_t data[2] = {(uint8_t)(keycode >> 8), (uint8_t)(keycode & 0xFF)};
+            eeprom_update_block(data, (void *)DYNAMIC_KEYMAP_POOL_EEPROM_ADDR + slot * 2, 2);
+            bitmap[key / 8] |= 1 << (key % 8);
+            slot++;
+        }
+        eeprom_update_block(bitmap, (void *)DYNAMIC_KEYMAP_EEPROM_ADDR + layer * DYNAMIC_KEYMAP_BITMAP_SIZE, DYNAMIC_KEYMAP_BITMAP_SIZE);
+    }
+    eeprom_update_byte((uint8_t *)DYNAMIC_KEYMAP_PENDING_EEPROM_ADDR, DYNAMIC_KEYMAP_NONE_PENDING);
+    dynamic_keymap_layer_start[DYNAMIC_KEYMAP_LAYER_COUNT] = slot;
+    memset(dynamic_keymap_cache_index, 0xFF, sizeof(dynamic_keymap_cache_index));
+    dynamic_keymap_sparse_loaded = true;
+}
+
+static void dynamic_keymap_sparse_load(void) {
+    // Layers left pending by a reset part way through moving the pool can no longer
+    // be decoded, so they go back to the keymap in flash
+    uint8_t pending = eeprom_read_byte((uint8_t *)DYNAMIC_KEYMAP_PENDING_EEPROM_ADDR);
+    if (pending < DYNAMIC_KEYMAP_LAYER_COUNT) {
+        dynamic_keymap_sparse_reset(pending);
+        return;
+    }
+    dynamic_keymap_sparse_count();
+    memset(dynamic_keymap_cache_index, 0xFF, sizeof(dynamic_keymap_cache_index));
+    dynamic_keymap_sparse_loaded = true;
+}
+
+// Finds the pool slot of a key, or of where it would go, returns false if the key is transparent
+static bool dynamic_keymap_sparse_locate(uint16_t index, uint16_t *slot) {
+    uint8_t  bitmap[DYNAMIC_KEYMAP_BITMAP_SIZE];
+    uint8_t  layer = index / DYNAMIC_KEYMAP_LAYER_KEYS;
+    uint16_t key   = index % DYNAMIC_KEYMAP_LAYER_KEYS;
+    uint8_t  byte  = key / 8;
+    uint16_t count = 0;
+    if (index >= DYNAMIC_KEYMAP_KEY_COUNT) {
+        *slot = dynamic_keymap_layer_start[DYNAMIC_KEYMAP_LAYER_COUNT];
+        return false;
+    }
+    eeprom_read_block(bitmap, (void *)DYNAMIC_KEYMAP_EEPROM_ADDR + layer * DYNAMIC_KEYMAP_BITMAP_SIZE, byte + 1);
+    for (uint8_t i = 0; i < byte; i++) {
+        count += dynamic_keymap_popcount(bitmap[i]);
+    }
+    count += dynamic_keymap_popcount(bitmap[byte] & ((1 << (key % 8)) - 1));
+    *slot = dynamic_keymap_layer_start[layer] + count;
+    return bitmap[byte] & (1 << (key % 8));
+}
+
+// Moves the keycodes in pool slots [start, end) by delta slots, copying in the
+// order that never overwrites a keycode before it has been read
+static void dynamic_keymap_sparse_move(uint16_t start, uint16_t end, int16_t delta) {
+    uint8_t  data[32];
+    uint8_t *pool = (uint8_t *)DYNAMIC_KEYMAP_POOL_EEPROM_ADDR;
+    uint16_t length;
+    start *= 2;
+    end *= 2;
+    if (delta > 0) {
+        while (end > start) {
+            length = end - start < sizeof(data) ? end - start : sizeof(data);
+            end -= length;
+            eeprom_read_block(data, pool + end, length);
+            eeprom_update_block(data, pool + end + delta * 2, length);
+        }
+    } else if (delta < 0) {
+        while (start < end) {
+            length = end - start < sizeof(data) ? end - start : sizeof(data);
+            eeprom_read_block(data, pool + start, length);
+            eeprom_update_block(data, pool + start + delta * 2, length);
+            start += length;
+        }
+    }
+}
+
+static uint8_t *dynamic_keymap_sparse_bitmap_byte(uint16_t index) { return (uint8_t *)DYNAMIC_KEYMAP_EEPROM_ADDR + index / DYNAMIC_KEYMAP_LAYER_KEYS * DYNAMIC_KEYMAP_BITMAP_SIZE + index % DYNAMIC_KEYMAP_LAYER_KEYS / 8; }
+
+// Sets or clears the bitmap bits of count keys from index, all cleared if keycodes is NULL,
+// one byte at a time in ascending or descending key order
+static void dynamic_keymap_sparse_update_bitmap(uint16_t index, uint16_t count, const uint16_t *keycodes, bool descending) {
+    uint16_t i = 0;
+    while (i < count) {
+        uint8_t *bitmap = dynamic_keymap_sparse_bitmap_byte(index + (descending ? count - 1 - i : i));
+        uint8_t  bits   = eeprom_read_byte(bitmap);
+        for (; i < count; i++) {
+            uint16_t n = descending ? count - 1 - i : i;
+            if (dynamic_keymap_sparse_bitmap_byte(index + n) != bitmap) {
+                break;
+            }
+            uint8_t bit = 1 << ((index + n) % DYNAMIC_KEYMAP_LAYER_KEYS % 8);
+            bits        = (keycodes == NULL || keycodes[n] == KC_TRNS) ? bits & ~bit : bits | bit;
+        }
+        eeprom_update_byte(bitmap, bits);
+    }
+}
+
+static uint16_t dynamic_keymap_sparse_get(uint16_t index) {
+    uint8_t cache = index % DYNAMIC_KEYMAP_SPARSE_CACHE_SIZE;
+    if (!dynamic_keymap_sparse_loaded) {
+        dynamic_keymap_sparse_load();
+    }
+    if (dynamic_keymap_cache_index[cache] == index) {
+        return dynamic_keymap_cache_keycode[cache];
+    }
+
+    uint16_t slot;
+    uint16_t keycode = KC_TRNS;
+    if (dynamic_keymap_sparse_locate(index, &slot)) {
+        // Big endian, like the dense layout
+        uint8_t data[2] = {0, 0};
+        if (slot < DYNAMIC_KEYMAP_SPARSE_KEY_COUNT) {
+            eeprom_read_block(data, (void *)DYNAMIC_KEYMAP_POOL_EEPROM_ADDR + slot * 2, 2);
+        }
+        keycode = (data[0] << 8) | data[1];
+    }
+    dynamic_keymap_cache_index[cache]   = index;
+    dynamic_keymap_cache_keycode[cache] = keycode;
+    return keycode;
+}
+
+// Stores count keycodes from index, moving the rest of the pool at most once. Nothing is stored if the pool cannot hold the new keycodes.
+//
+// Keys past the last non-transparent one are appended by writing the pool before the bitmap,
+// and cleared by clearing their bits last to first, so either can be interrupted by a reset.
+// Anything else moves the pool under later layers, so the first layer touched is marked
+// pending until the bitmaps agree with the pool again.
+static bool dynamic_keymap_sparse_set_range(uint16_t index, uint16_t count, const uint16_t *keycodes) {
+    uint16_t used;
+    uint16_t first;
+    uint16_t last;
+    uint16_t present = 0;
+    bool     moved   = false;
+    bool     same    = true;
+    for (uint16_t i = 0; i < count; i++) {
+        same = same && dynamic_keymap_sparse_get(index + i) == keycodes[i];
+        if (keycodes[i] != KC_TRNS) {
+            present++;
+        }
+    }
+    if (same) {
+        return true;
+    }
+    used = dynamic_keymap_layer_start[DYNAMIC_KEYMAP_LAYER_COUNT];
+    dynamic_keymap_sparse_locate(index, &first);
+    dynamic_keymap_sparse_locate(index + count, &last);
+    if (used - (last - first) + present > DYNAMIC_KEYMAP_SPARSE_KEY_COUNT) {
+        return false;
+    }
+
+    if (present == 0 && last == used) {
+        dynamic_keymap_sparse_update_bitmap(index, count, NULL, true);
+    } else {
+        if (first != used) {
+            // Keycodes that only change value, not whether they are transparent, are overwritten in place
+            for (uint16_t i = 0; i < count && !moved; i++) {
+                moved = (dynamic_keymap_sparse_get(index + i) == KC_TRNS) != (keycodes[i] == KC_TRNS);
+            }
+        }
+        if (moved) {
+            eeprom_update_byte((uint8_t *)DYNAMIC_KEYMAP_PENDING_EEPROM_ADDR, index / DYNAMIC_KEYMAP_LAYER_KEYS);
+            dynamic_keymap_sparse_move(last, used, (int16_t)present - (int16_t)(last - first));
+        }
+        for (uint16_t i = 0, slot = first; i < count; i++) {
+            if (keycodes[i] != KC_TRNS) {
+                uint8_t data[2] = {(uint8_t)(keycodes[i] >> 8), (uint8_t)(keycodes[i] & 0xFF)};
+                eeprom_update_block(data, (void *)DYNAMIC_KEYMAP_POOL_EEPROM_ADDR + slot * 2, 2);
+                slot++;
+            }
+        }
+        dynamic_keymap_sparse_update_bitmap(index, count, keycodes, false);
+        if (moved) {
+            eeprom_update_byte((uint8_t *)DYNAMIC_KEYMAP_PENDING_EEPROM_ADDR, DYNAMIC_KEYMAP_NONE_PENDING);
+        }
+    }
+
+    dynamic_keymap_sparse_count();
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t cache                       = (index + i) % DYNAMIC_KEYMAP_SPARSE_CACHE_SIZE;
+        dynamic_keymap_cache_index[cache]   = index + i;
+        dynamic_keymap_cache_keycode[cache] = keycodes[i];
+    }
+    return true;
+}
+
+// Clears every key from index to the end of the keymap, last to first
+static void dynamic_keymap_sparse_truncate(uint16_t index) {
+    if (!dynamic_keymap_sparse_loaded) {
+        dynamic_keymap_sparse_load();
+    }
+    dynamic_keymap_sparse_update_bitmap(index, DYNAMIC_KEYMAP_KEY_COUNT - index, NULL, true);
+    dynamic_keymap_sparse_count();
+    memset(dynamic_keymap_cache_index, 0xFF, sizeof(dynamic_keymap_cache_index));
+}
+#endif
+
+void dynamic_keymap_init(void) {
+#ifdef DYNAMIC_KEYMAP_RAM_MIRROR
+    dynamic_keymap_mirror_load();
+#elif defined(DYNAMIC_KEYMAP_SPARSE)
+    dynamic_keymap_sparse_load();
+#endif
+}
+
+static void dynamic_keymap_macro_task(void);
+
+void dynamic_keymap_task(void) {
+    dynamic_keymap_macro_task();
+#ifdef DYNAMIC_KEYMAP_RAM_MIRROR
+    if (dynamic_keymap_dirty_count == 0 || timer_elapsed(dynamic_keymap_dirty_timer) < DYNAMIC_KEYMAP_WRITE_BACK_DELAY) {
+        return;
+    }
+    dynamic_keymap_write_back_next();
+#endif
+}
+
+void dynamic_keymap_flush(void) {
+#ifdef DYNAMIC_KEYMAP_RAM_MIRROR
+    while (dynamic_keymap_dirty_count > 0) {
+        dynamic_keymap_write_back_next();
+    }
+#endif
+}
+
+uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column) {
+#ifdef DYNAMIC_KEYMAP_RAM_MIRROR
+    if (!dynamic_keymap_mirror_loaded) {
+        dynamic_keymap_mirror_load();
+    }
+    return dynamic_keymap_mirror[(layer * MATRIX_ROWS + row) * MATRIX_COLS + column];
+#elif defined(DYNAMIC_KEYMAP_SPARSE)
+    return dynamic_keymap_sparse_get((layer * MATRIX_ROWS + row) * MATRIX_COLS + column);
+#else
+    return dynamic_keymap_read_keycode(dynamic_keymap_key_to_eeprom_address(layer, row, column));
+#endif
+}
+
+bool dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode) {
+#ifdef DYNAMIC_KEYMAP_RAM_MIRROR
+    dynamic_keymap_mirror_set((layer * MATRIX_ROWS + row) * MATRIX_COLS + column, keycode);
+#elif defined(DYNAMIC_KEYMAP_SPARSE)
+    return dynamic_keymap_sparse_set_range((layer * MATRIX_ROWS + row) * MATRIX_COLS + column, 1, &keycode);
+#else
+    dynamic_keymap_write_keycode(dynamic_keymap_key_to_eeprom_address(layer, row, column), keycode);
+#endif
+    return true;
 }
 
 void dynamic_keymap_reset(void) {
     // Reset the keymaps in EEPROM to what is in flash.
     // All keyboards using dynamic keymaps should define a layout
     // for the same number of layers as DYNAMIC_KEYMAP_LAYER_COUNT.
+#ifdef DYNAMIC_KEYMAP_SPARSE
+    dynamic_keymap_sparse_reset(0);
+#else
     for (int layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
         for (int row = 0; row < MATRIX_ROWS; row++) {
             for (int column = 0; column < MATRIX_COLS; column++) {
@@ -110,36 +574,115 @@ void dynamic_keymap_reset(void) {
             }
         }
     }
+#endif
+    // Callers expect the reset keymap to be in EEPROM on return
+    dynamic_keymap_flush();
 }
 
+#ifdef DYNAMIC_KEYMAP_RAM_MIRROR
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   source                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
+    uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_KEY_COUNT * 2;
     uint8_t *target                     = data;
+    if (!dynamic_keymap_mirror_loaded) {
+        dynamic_keymap_mirror_load();
+    }
     for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < dynamic_keymap_eeprom_size) {
-            *target = eeprom_read_byte(source);
+        uint16_t address = offset + i;
+        if (address < dynamic_keymap_eeprom_size) {
+            // Serve the big endian EEPROM layout from the native endian mirror
+            uint16_t keycode = dynamic_keymap_mirror[address / 2];
+            *target          = (address & 1) ? (uint8_t)(keycode & 0xFF) : (uint8_t)(keycode >> 8);
         } else {
             *target = 0x00;
         }
-        source++;
         target++;
     }
 }
 
-void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   target                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
+bool dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
+    uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_KEY_COUNT * 2;
     uint8_t *source                     = data;
+    if (!dynamic_keymap_mirror_loaded) {
+        dynamic_keymap_mirror_load();
+    }
     for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < dynamic_keymap_eeprom_size) {
-            eeprom_update_byte(target, *source);
+        uint16_t address = offset + i;
+        if (address < dynamic_keymap_eeprom_size) {
+            // A packet may end half way through a keycode, so patch one byte at a time
+            uint16_t keycode = dynamic_keymap_mirror[address / 2];
+            keycode          = (address & 1) ? ((keycode & 0xFF00) | *source) : ((keycode & 0x00FF) | (*source << 8));
+            dynamic_keymap_mirror_set(address / 2, keycode);
         }
         source++;
+    }
+    return true;
+}
+
+void dynamic_keymap_set_buffer_begin(uint16_t offset, uint16_t size) {}
+#elif defined(DYNAMIC_KEYMAP_SPARSE)
+void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
+    uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_KEY_COUNT * 2;
+    uint8_t *target                     = data;
+    for (uint16_t i = 0; i < size; i++) {
+        uint16_t address = offset + i;
+        if (address < dynamic_keymap_eeprom_size) {
+            // Serve the dense big endian layout from the decoded keycodes
+            uint16_t keycode = dynamic_keymap_sparse_get(address / 2);
+            *target          = (address & 1) ? (uint8_t)(keycode & 0xFF) : (uint8_t)(keycode >> 8);
+        } else {
+            *target = 0x00;
+        }
         target++;
     }
 }
 
+bool dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
+    uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_KEY_COUNT * 2;
+    uint16_t keycodes[16];
+    uint16_t i = 0;
+    while (i < size && offset + i < dynamic_keymap_eeprom_size) {
+        // Decode as many keycodes as fit, so the pool is moved at most once for all of them
+        uint16_t index = (offset + i) / 2;
+        uint8_t  count = 0;
+        while (count < sizeof(keycodes) / sizeof(keycodes[0]) && i < size && offset + i < dynamic_keymap_eeprom_size) {
+            // A packet may start or end half way through a keycode, keeping its other byte
+            uint16_t address = offset + i;
+            bool     whole   = !(address & 1) && i + 1 < size;
+            uint16_t keycode = whole ? 0 : dynamic_keymap_sparse_get(address / 2);
+            if (!(address & 1)) {
+                keycode = (keycode & 0x00FF) | (data[i++] << 8);
+            }
+            if (i < size) {
+                keycode = (keycode & 0xFF00) | data[i++];
+            }
+            keycodes[count++] = keycode;
+        }
+        if (!dynamic_keymap_sparse_set_range(index, count, keycodes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void dynamic_keymap_set_buffer_begin(uint16_t offset, uint16_t size) {
+    // A transfer running to the end of the keymap replaces every key it reaches, so the keys after
+    // the first one are dropped up front and then appended in order, without moving the pool
+    uint16_t index = (offset + 1) / 2;
+    if ((uint32_t)offset + size >= DYNAMIC_KEYMAP_KEY_COUNT * 2 && index < DYNAMIC_KEYMAP_KEY_COUNT) {
+        dynamic_keymap_sparse_truncate(index);
+    }
+}
+#else
+void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) { dynamic_keymap_read_buffer((void *)DYNAMIC_KEYMAP_EEPROM_ADDR, DYNAMIC_KEYMAP_KEY_COUNT * 2, offset, size, data); }
+
+bool dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
+    dynamic_keymap_update_buffer((void *)DYNAMIC_KEYMAP_EEPROM_ADDR, DYNAMIC_KEYMAP_KEY_COUNT * 2, offset, size, data);
+    return true;
+}
+
+void dynamic_keymap_set_buffer_begin(uint16_t offset, uint16_t size) {}
+#endif
+
 // This overrides the one in quantum/keymap_common.c
 uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
     if (layer < DYNAMIC_KEYMAP_LAYER_COUNT && key.row < MATRIX_ROWS && key.col < MATRIX_COLS) {
@@ -153,38 +696,111 @@ uint8_t dynamic_keymap_macro_get_count(void) { return DYNAMIC_KEYMAP_MACRO_COUNT
 
 uint16_t dynamic_keymap_macro_get_buffer_size(void) { return DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE; }
 
-void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   source = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
-    uint8_t *target = data;
-    for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
-            *target = eeprom_read_byte(source);
-        } else {
-            *target = 0x00;
+void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) { dynamic_keymap_read_buffer((void *)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR, DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE, offset, size, data); }
+
+// Stops playback and drops the offset table, for when the macro buffer is being changed
+static void dynamic_keymap_macro_invalidate(void) {
+    dynamic_keymap_macro_indexed          = false;
+    dynamic_keymap_macro_play.active      = false;
+    dynamic_keymap_macro_play.queue_count = 0;
+}
+
+void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
+    dynamic_keymap_macro_invalidate();
+    dynamic_keymap_update_buffer((void *)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR, DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE, offset, size, data);
+}
+
+void dynamic_keymap_macro_reset(void) {
+    uint8_t zeros[32] = {0};
+    dynamic_keymap_macro_invalidate();
+    for (uint16_t offset = 0; offset < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE; offset += sizeof(zeros)) {
+        dynamic_keymap_update_buffer((void *)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR, DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE, offset, sizeof(zeros), zeros);
+    }
+}
+
+// Finds where each macro starts in a single pass over the buffer
+static void dynamic_keymap_macro_index(void) {
+    uint8_t  data[32];
+    uint8_t  id     = 0;
+    uint16_t offset = 0;
+    dynamic_keymap_macro_offsets[id++] = 0;
+    while (id < DYNAMIC_KEYMAP_MACRO_COUNT && offset < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
+        uint16_t length = DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - offset < sizeof(data) ? DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - offset : sizeof(data);
+        eeprom_read_block(data, (void *)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset, length);
+        for (uint8_t i = 0; i < length && id < DYNAMIC_KEYMAP_MACRO_COUNT; i++) {
+            if (data[i] == 0) {
+                dynamic_keymap_macro_offsets[id++] = offset + i + 1;
+            }
         }
-        source++;
-        target++;
+        offset += length;
+    }
+    // If there were not DYNAMIC_KEYMAP_MACRO_COUNT nulls in the buffer,
+    // the buffer contents are garbage, so the missing macros are left empty
+    while (id < DYNAMIC_KEYMAP_MACRO_COUNT) {
+        dynamic_keymap_macro_offsets[id++] = DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE;
     }
+    dynamic_keymap_macro_indexed = true;
 }
 
-void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   target = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
-    uint8_t *source = data;
-    for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
-            eeprom_update_byte(target, *source);
+static void dynamic_keymap_macro_start(uint8_t id) {
+    if (!dynamic_keymap_macro_indexed) {
+        dynamic_keymap_macro_index();
+    }
+    dynamic_keymap_macro_play.offset = dynamic_keymap_macro_offsets[id];
+    dynamic_keymap_macro_play.head   = 0;
+    dynamic_keymap_macro_play.length = 0;
+    dynamic_keymap_macro_play.active = true;
+}
+
+// Returns the next byte of the playing macro, reading ahead a chunk at a time
+static uint8_t dynamic_keymap_macro_next(void) {
+    if (dynamic_keymap_macro_play.head == dynamic_keymap_macro_play.length) {
+        uint16_t remaining = DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - dynamic_keymap_macro_play.offset;
+        if (remaining == 0) {
+            return 0;
         }
-        source++;
-        target++;
+        dynamic_keymap_macro_play.length = remaining < sizeof(dynamic_keymap_macro_play.buffer) ? remaining : sizeof(dynamic_keymap_macro_play.buffer);
+        dynamic_keymap_macro_play.head   = 0;
+        eeprom_read_block(dynamic_keymap_macro_play.buffer, (void *)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + dynamic_keymap_macro_play.offset, dynamic_keymap_macro_play.length);
+        dynamic_keymap_macro_play.offset += dynamic_keymap_macro_play.length;
     }
+    return dynamic_keymap_macro_play.buffer[dynamic_keymap_macro_play.head++];
 }
 
-void dynamic_keymap_macro_reset(void) {
-    void *p   = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
-    void *end = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
-    while (p != end) {
-        eeprom_update_byte(p, 0);
-        ++p;
+// Plays back a bounded number of macro actions, so the matrix keeps being scanned during long macros
+static void dynamic_keymap_macro_task(void) {
+    for (uint8_t actions = 0; actions < DYNAMIC_KEYMAP_MACRO_ACTIONS_PER_TASK; actions++) {
+        if (!dynamic_keymap_macro_play.active) {
+            if (dynamic_keymap_macro_play.queue_count == 0) {
+                return;
+            }
+            dynamic_keymap_macro_start(dynamic_keymap_macro_play.queue[0]);
+            dynamic_keymap_macro_play.queue_count--;
+            memmove(dynamic_keymap_macro_play.queue, dynamic_keymap_macro_play.queue + 1, dynamic_keymap_macro_play.queue_count);
+        }
+
+        uint8_t data = dynamic_keymap_macro_next();
+        // Stop at the null terminator of this macro string
+        if (data == 0) {
+            dynamic_keymap_macro_play.active = false;
+            continue;
+        }
+        // If the char is magic (tap, down, up),
+        // the next char is the key to use
+        if (data == SS_TAP_CODE || data == SS_DOWN_CODE || data == SS_UP_CODE) {
+            uint8_t keycode = dynamic_keymap_macro_next();
+            if (keycode == 0) {
+                dynamic_keymap_macro_play.active = false;
+            } else if (data == SS_TAP_CODE) {
+                tap_code(keycode);
+            } else if (data == SS_DOWN_CODE) {
+                register_code(keycode);
+            } else {
+                unregister_code(keycode);
+            }
+        } else {
+            send_char(data);
+        }
     }
 }
 
@@ -202,45 +818,8 @@ void dynamic_keymap_macro_send(uint8_t id) {
         return;
     }
 
-    // Skip N null characters
-    // p will then point to the Nth macro
-    p         = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
-    void *end = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
-    while (id > 0) {
-        // If we are past the end of the buffer, then the buffer
-        // contents are garbage, i.e. there were not DYNAMIC_KEYMAP_MACRO_COUNT
-        // nulls in the buffer.
-        if (p == end) {
-            return;
-        }
-        if (eeprom_read_byte(p) == 0) {
-            --id;
-        }
-        ++p;
-    }
-
-    // Send the macro string one or three chars at a time
-    // by making temporary 1 or 3 char strings
-    char data[4] = {0, 0, 0, 0};
-    // We already checked there was a null at the end of
-    // the buffer, so this cannot go past the end
-    while (1) {
-        data[0] = eeprom_read_byte(p++);
-        data[1] = 0;
-        // Stop at the null terminator of this macro string
-        if (data[0] == 0) {
-            break;
-        }
-        // If the char is magic (tap, down, up),
-        // add the next char (key to use) and send a 3 char string.
-        if (data[0] == SS_TAP_CODE || data[0] == SS_DOWN_CODE || data[0] == SS_UP_CODE) {
-            data[1] = data[0];
-            data[0] = SS_QMK_PREFIX;
-            data[2] = eeprom_read_byte(p++);
-            if (data[2] == 0) {
-                break;
-            }
-        }
-        send_string(data);
+    // Queue the macro to be played back by dynamic_keymap_task()
+    if (dynamic_keymap_macro_play.queue_count < DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE) {
+        dynamic_keymap_macro_play.queue[dynamic_keymap_macro_play.queue_count++] = id;
     }
 }
@@ -18,11 +18,28 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-uint8_t  dynamic_keymap_get_layer_count(void);
-void *   dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t column);
+uint8_t dynamic_keymap_get_layer_count(void);
+#ifndef DYNAMIC_KEYMAP_SPARSE
+void *dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t column);
+#endif
 uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column);
-void     dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode);
-void     dynamic_keymap_reset(void);
+// Returns false if the keycode could not be stored, which only happens once the sparse pool is full
+bool dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode);
+void dynamic_keymap_reset(void);
+// With DYNAMIC_KEYMAP_RAM_MIRROR, keycodes are served from RAM and changes are
+// written back to EEPROM by dynamic_keymap_task() once the keymap has been left alone
+// for DYNAMIC_KEYMAP_WRITE_BACK_DELAY ms. dynamic_keymap_flush() writes them back now.
+void dynamic_keymap_init(void);
+void dynamic_keymap_task(void);
+void dynamic_keymap_flush(void);
+// With DYNAMIC_KEYMAP_SPARSE, each layer is stored as a bitmap of its non-transparent keys
+// plus their keycodes, packed into a pool of DYNAMIC_KEYMAP_SPARSE_KEY_COUNT keycodes shared
+// by all layers. Lookups go through a RAM cache of DYNAMIC_KEYMAP_SPARSE_CACHE_SIZE decoded
+// keycodes. Making a key transparent or not moves the rest of the pool, so setting keys
+// is slower than with the dense layout. Once the pool is full, keys that would need a slot
+// are left unchanged and the set functions return false. A reset while the pool is being
+// moved loses the changes to the layer being set and later ones: they are rebuilt from the
+// keymap in flash on the next boot, rather than decoded from a half moved pool.
 // These get/set the keycodes as stored in the EEPROM buffer
 // Data is big-endian 16-bit values (the keycodes)
 // Order is by layer/row/column
@@ -32,7 +49,12 @@ void     dynamic_keymap_reset(void);
 // by reading 14 keycodes (28 bytes) at a time, reducing the number of raw HID transfers by
 // a factor of 14.
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data);
-void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data);
+bool dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data);
+// Announces a transfer that writes size bytes from offset in order with dynamic_keymap_set_buffer().
+// With DYNAMIC_KEYMAP_SPARSE, a transfer that runs to the end of the keymap clears those keys up
+// front so they are appended rather than moving the pool on every packet. Keys the transfer does
+// not reach, should it be abandoned, are left transparent.
+void dynamic_keymap_set_buffer_begin(uint16_t offset, uint16_t size);
 
 // This overrides the one in quantum/keymap_common.c
 // uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
@@ -57,4 +79,7 @@ void     dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t
 void     dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data);
 void     dynamic_keymap_macro_reset(void);
 
+// Queues a macro to be played back by dynamic_keymap_task(), which plays
+// DYNAMIC_KEYMAP_MACRO_ACTIONS_PER_TASK characters or key codes per call so the
+// matrix keeps being scanned while long macros are typed out.
 void dynamic_keymap_macro_send(uint8_t id);
@@ -22,6 +22,9 @@
 
 // for memcpy
 #include <string.h>
+#if defined(ENCODER_TIMER_SAMPLING) && defined(__AVR__)
+#    include <util/atomic.h>
+#endif
 
 #ifndef ENCODER_RESOLUTION
 #    define ENCODER_RESOLUTION 4
@@ -56,6 +59,30 @@ static uint8_t thisHand, thatHand;
 static uint8_t encoder_value[NUMBER_OF_ENCODERS] = {0};
 #endif
 
+#ifdef ENCODER_TIMER_SAMPLING
+#    if !defined(__AVR__) && !defined(PROTOCOL_CHIBIOS)
+#        error "ENCODER_TIMER_SAMPLING is only supported on AVR and ChibiOS"
+#    endif
+// Steps counted by encoder_sample() that encoder_read() hasn't handled yet, positive is counter clockwise
+static volatile int8_t encoder_steps[NUMBER_OF_ENCODERS] = {0};
+// The timer starts before the pins are set up
+static volatile bool encoder_sampling = false;
+#    ifdef PROTOCOL_CHIBIOS
+#        ifndef ENCODER_SAMPLE_INTERVAL_US
+#            define ENCODER_SAMPLE_INTERVAL_US 250
+#        endif
+#        define ENCODER_SAMPLE_TICKS (TIME_US2I(ENCODER_SAMPLE_INTERVAL_US) ? TIME_US2I(ENCODER_SAMPLE_INTERVAL_US) : 1)
+static virtual_timer_t encoder_sample_timer;
+
+static void encoder_sample_cb(void *arg) {
+    chSysLockFromISR();
+    chVTSetI(&encoder_sample_timer, ENCODER_SAMPLE_TICKS, encoder_sample_cb, NULL);
+    chSysUnlockFromISR();
+    encoder_sample();
+}
+#    endif
+#endif
+
 __attribute__((weak)) void encoder_update_user(int8_t index, bool clockwise) {}
 
 __attribute__((weak)) void encoder_update_kb(int8_t index, bool clockwise) { encoder_update_user(index, clockwise); }
@@ -83,13 +110,36 @@ void encoder_init(void) {
     thisHand = isLeftHand ? 0 : NUMBER_OF_ENCODERS;
     thatHand = NUMBER_OF_ENCODERS - thisHand;
 #endif
+
+#ifdef ENCODER_TIMER_SAMPLING
+    encoder_sampling = true;
+#    ifdef PROTOCOL_CHIBIOS
+    chVTObjectInit(&encoder_sample_timer);
+    chVTSet(&encoder_sample_timer, ENCODER_SAMPLE_TICKS, encoder_sample_cb, NULL);
+#    endif
+#endif
 }
 
+// Calls the update callback once for every step, in the direction of the step
+static void encoder_apply_steps(uint8_t index, int8_t steps) {
+    while (steps > 0) {
+        steps--;
+        encoder_value[index]++;
+        encoder_update_kb(index, ENCODER_COUNTER_CLOCKWISE);
+    }
+    while (steps < 0) {
+        steps++;
+        encoder_value[index]--;
+        encoder_update_kb(index, ENCODER_CLOCKWISE);
+    }
+}
+
+#ifndef ENCODER_TIMER_SAMPLING
 static void encoder_update(int8_t index, uint8_t state) {
     uint8_t i = index;
-#ifdef SPLIT_KEYBOARD
+#    ifdef SPLIT_KEYBOARD
     index += thisHand;
-#endif
+#    endif
     encoder_pulses[i] += encoder_LUT[state & 0xF];
     if (encoder_pulses[i] >= ENCODER_RESOLUTION) {
         encoder_value[index]++;
@@ -101,7 +151,58 @@ static void encoder_update(int8_t index, uint8_t state) {
     }
     encoder_pulses[i] %= ENCODER_RESOLUTION;
 }
+#endif
+
+#ifdef ENCODER_TIMER_SAMPLING
+/**
+ * Called from the timer interrupt. Only decodes the pins and counts steps, the
+ * callbacks run later from encoder_read(), so a slow main loop no longer misses transitions.
+ */
+void encoder_sample(void) {
+    if (!encoder_sampling) {
+        return;
+    }
+    for (uint8_t i = 0; i < NUMBER_OF_ENCODERS; i++) {
+        encoder_state[i] <<= 2;
+        encoder_state[i] |= (readPin(encoders_pad_a[i]) << 0) | (readPin(encoders_pad_b[i]) << 1);
+        encoder_pulses[i] += encoder_LUT[encoder_state[i] & 0xF];
+        if (encoder_pulses[i] >= ENCODER_RESOLUTION && encoder_steps[i] < INT8_MAX) {
+            encoder_steps[i]++;
+        }
+        if (encoder_pulses[i] <= -ENCODER_RESOLUTION && encoder_steps[i] > -INT8_MAX) {
+            encoder_steps[i]--;
+        }
+        encoder_pulses[i] %= ENCODER_RESOLUTION;
+    }
+}
+
+static int8_t encoder_take_steps(uint8_t i) {
+    int8_t steps;
+#    if defined(__AVR__)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        steps            = encoder_steps[i];
+        encoder_steps[i] = 0;
+    }
+#    else
+    chSysLock();
+    steps            = encoder_steps[i];
+    encoder_steps[i] = 0;
+    chSysUnlock();
+#    endif
+    return steps;
+}
 
+void encoder_read(void) {
+    for (uint8_t i = 0; i < NUMBER_OF_ENCODERS; i++) {
+        int8_t steps = encoder_take_steps(i);
+#    ifdef SPLIT_KEYBOARD
+        encoder_apply_steps(i + thisHand, steps);
+#    else
+        encoder_apply_steps(i, steps);
+#    endif
+    }
+}
+#else
 void encoder_read(void) {
     for (uint8_t i = 0; i < NUMBER_OF_ENCODERS; i++) {
         encoder_state[i] <<= 2;
@@ -109,6 +210,7 @@ void encoder_read(void) {
         encoder_update(i, encoder_state[i]);
     }
 }
+#endif
 
 #ifdef SPLIT_KEYBOARD
 void encoder_state_raw(uint8_t* slave_state) { memcpy(slave_state, &encoder_value[thisHand], sizeof(uint8_t) * NUMBER_OF_ENCODERS); }
@@ -116,17 +218,7 @@ void encoder_state_raw(uint8_t* slave_state) { memcpy(slave_state, &encoder_valu
 void encoder_update_raw(uint8_t* slave_state) {
     for (uint8_t i = 0; i < NUMBER_OF_ENCODERS; i++) {
         uint8_t index = i + thatHand;
-        int8_t  delta = slave_state[i] - encoder_value[index];
-        while (delta > 0) {
-            delta--;
-            encoder_value[index]++;
-            encoder_update_kb(index, ENCODER_COUNTER_CLOCKWISE);
-        }
-        while (delta < 0) {
-            delta++;
-            encoder_value[index]--;
-            encoder_update_kb(index, ENCODER_CLOCKWISE);
-        }
+        encoder_apply_steps(index, slave_state[i] - encoder_value[index]);
     }
 }
 #endif
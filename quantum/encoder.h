@@ -21,6 +21,9 @@
 
 void encoder_init(void);
 void encoder_read(void);
+#ifdef ENCODER_TIMER_SAMPLING
+void encoder_sample(void);
+#endif
 
 void encoder_update_kb(int8_t index, bool clockwise);
 void encoder_update_user(int8_t index, bool clockwise);
@@ -25,13 +25,94 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 static report_mouse_t mouseReport = {};
 
+/*
+ * Motion read from the sensor but not yet sent. 16 bits wide so a fast
+ * flick between two reports doesn't clip at the -127..127 a report holds.
+ */
+static pointing_device_motion_t pointing_device_accum        = {};
+static int16_t                  pointing_device_remainder_x  = 0;
+static int16_t                  pointing_device_remainder_y  = 0;
+static uint16_t                 pointing_device_cpi_scale    = POINTING_DEVICE_CPI_SCALE;
+static uint16_t                 pointing_device_last_send    = 0;
+static uint8_t                  pointing_device_last_buttons = 0;
+
+__attribute__((weak)) void pointing_device_driver_init(void) {}
+
+__attribute__((weak)) bool pointing_device_driver_read(pointing_device_motion_t *motion) { return false; }
+
+__attribute__((weak)) pointing_device_motion_t pointing_device_filter_user(pointing_device_motion_t motion) { return motion; }
+
+__attribute__((weak)) pointing_device_motion_t pointing_device_filter_kb(pointing_device_motion_t motion) { return pointing_device_filter_user(motion); }
+
+static int16_t pointing_device_saturate(int32_t value) {
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    } else if (value < -INT16_MAX) {
+        return -INT16_MAX;
+    }
+    return value;
+}
+
+// Scales sensor counts, carrying the fraction over to the next read so slow movement isn't lost
+static int16_t pointing_device_scale(int16_t counts, int16_t *remainder) {
+    int32_t scaled = (int32_t)counts * pointing_device_cpi_scale + *remainder;
+    int32_t whole  = scaled / 256;
+    *remainder     = scaled - whole * 256;
+    return pointing_device_saturate(whole);
+}
+
+// Moves up to a report's worth of motion out of an accumulator
+static int8_t pointing_device_take(int16_t *accum, int8_t current) {
+    int16_t value = *accum + current;
+    if (value > 127) {
+        value = 127;
+    } else if (value < -127) {
+        value = -127;
+    }
+    *accum -= value - current;
+    return value;
+}
+
+/**
+ * Adds motion to what will be sent with the next report, after the filter and CPI scaling stages.
+ */
+void pointing_device_add_motion(pointing_device_motion_t motion) {
+    motion                  = pointing_device_filter_kb(motion);
+    pointing_device_accum.x = pointing_device_saturate((int32_t)pointing_device_accum.x + pointing_device_scale(motion.x, &pointing_device_remainder_x));
+    pointing_device_accum.y = pointing_device_saturate((int32_t)pointing_device_accum.y + pointing_device_scale(motion.y, &pointing_device_remainder_y));
+    pointing_device_accum.v = pointing_device_saturate((int32_t)pointing_device_accum.v + motion.v);
+    pointing_device_accum.h = pointing_device_saturate((int32_t)pointing_device_accum.h + motion.h);
+}
+
+/**
+ * Reads the sensor. Called every pointing_device_task(), and can be called more often, e.g. from
+ * matrix_scan_kb(), if the sensor would otherwise overflow its own counters between tasks.
+ */
+void pointing_device_poll(void) {
+    pointing_device_motion_t motion = {};
+    if (pointing_device_driver_read(&motion)) {
+        pointing_device_add_motion(motion);
+    }
+}
+
+uint16_t pointing_device_get_cpi_scale(void) { return pointing_device_cpi_scale; }
+
+void pointing_device_set_cpi_scale(uint16_t scale) {
+    pointing_device_cpi_scale   = scale;
+    pointing_device_remainder_x = 0;
+    pointing_device_remainder_y = 0;
+}
+
 __attribute__((weak)) void pointing_device_init(void) {
     // initialize device, if that needs to be done.
+    pointing_device_driver_init();
 }
 
 __attribute__((weak)) void pointing_device_send(void) {
     // If you need to do other things, like debugging, this is the place to do it.
     host_mouse_send(&mouseReport);
+    pointing_device_last_send    = timer_read();
+    pointing_device_last_buttons = mouseReport.buttons;
     // send it and 0 it out except for buttons, so those stay until they are explicity over-ridden using update_pointing_device
     mouseReport.x = 0;
     mouseReport.y = 0;
@@ -46,10 +127,21 @@ __attribute__((weak)) void pointing_device_task(void) {
     // mouseReport.v = 127 max -127 min (scroll vertical)
     // mouseReport.h = 127 max -127 min (scroll horizontal)
     // mouseReport.buttons = 0x1F (decimal 31, binary 00011111) max (bitmask for mouse buttons 1-5, 1 is rightmost, 5 is leftmost) 0x00 min
-    // send the report
-    pointing_device_send();
+    // or implement pointing_device_driver_read() and let the motion be accumulated here
+    pointing_device_poll();
+    if (timer_elapsed(pointing_device_last_send) < POINTING_DEVICE_REPORT_INTERVAL) {
+        return;
+    }
+    mouseReport.x = pointing_device_take(&pointing_device_accum.x, mouseReport.x);
+    mouseReport.y = pointing_device_take(&pointing_device_accum.y, mouseReport.y);
+    mouseReport.v = pointing_device_take(&pointing_device_accum.v, mouseReport.v);
+    mouseReport.h = pointing_device_take(&pointing_device_accum.h, mouseReport.h);
+    // send the report, if there is anything new in it
+    if (mouseReport.x || mouseReport.y || mouseReport.v || mouseReport.h || mouseReport.buttons != pointing_device_last_buttons) {
+        pointing_device_send();
+    }
 }
 
 report_mouse_t pointing_device_get_report(void) { return mouseReport; }
 
-void pointing_device_set_report(report_mouse_t newMouseReport) { mouseReport = newMouseReport; }
\ No newline at end of file
+void pointing_device_set_report(report_mouse_t newMouseReport) { mouseReport = newMouseReport; }
@@ -19,13 +19,43 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define POINTING_DEVICE_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "host.h"
 #include "report.h"
 
+/* 256 is one count per sensor count, 128 halves the speed and 512 doubles it */
+#ifndef POINTING_DEVICE_CPI_SCALE
+#    define POINTING_DEVICE_CPI_SCALE 256
+#endif
+
+/* minimum time in milliseconds between reports, motion read in between is accumulated */
+#ifndef POINTING_DEVICE_REPORT_INTERVAL
+#    define POINTING_DEVICE_REPORT_INTERVAL 1
+#endif
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t v;
+    int16_t h;
+} pointing_device_motion_t;
+
 void           pointing_device_init(void);
 void           pointing_device_task(void);
 void           pointing_device_send(void);
 report_mouse_t pointing_device_get_report(void);
 void           pointing_device_set_report(report_mouse_t newMouseReport);
 
+void     pointing_device_poll(void);
+void     pointing_device_add_motion(pointing_device_motion_t motion);
+uint16_t pointing_device_get_cpi_scale(void);
+void     pointing_device_set_cpi_scale(uint16_t scale);
+
+/* sensor driver, returns true and fills in the motion counted since the last read */
+void pointing_device_driver_init(void);
+bool pointing_device_driver_read(pointing_device_motion_t *motion);
+
+pointing_device_motion_t pointing_device_filter_kb(pointing_device_motion_t motion);
+pointing_device_motion_t pointing_device_filter_user(pointing_device_motion_t motion);
+
 #endif
@@ -29,7 +29,7 @@ static int8_t  selected_index;
 #endif
 
 void unicode_input_mode_init(void) {
-    unicode_config.raw = eeprom_read_byte(EECONFIG_UNICODEMODE);
+    unicode_config.raw = eeconfig_read_byte(EECONFIG_UNICODEMODE);
 #if UNICODE_SELECTED_MODES != -1
 #    if UNICODE_CYCLE_PERSIST
     // Find input_mode in selected modes
@@ -74,7 +74,7 @@ void cycle_unicode_input_mode(int8_t offset) {
 #endif
 }
 
-void persist_unicode_input_mode(void) { eeprom_update_byte(EECONFIG_UNICODEMODE, unicode_config.input_mode); }
+void persist_unicode_input_mode(void) { eeconfig_update_byte(EECONFIG_UNICODEMODE, unicode_config.input_mode); }
 
 __attribute__((weak)) void unicode_input_start(void) {
     unicode_saved_mods = get_mods();  // Save current mods
@@ -177,6 +177,8 @@ void register_unicode(uint32_t code_point) {
         return;
     }
 
+    // Anything still queued by SEND_STRING() goes before the code point
+    send_string_flush();
     unicode_input_start();
     if (code_point > 0xFFFF && unicode_config.input_mode == UC_MAC) {
         // Convert code point to UTF-16 surrogate pair on macOS
@@ -210,9 +212,11 @@ void send_unicode_hex_string(const char *str) {
             *p = tolower((unsigned char)*p);
         }
 
-        // Send the code point as a Unicode input string
+        // Send the code point as a Unicode input string, typed out before input is finished
+        send_string_flush();
         unicode_input_start();
         send_string(code_point);
+        send_string_flush();
         unicode_input_finish();
 
         str += n;  // Move to the first ' ' (or '\0') after the current token
@@ -141,6 +141,12 @@ void reset_keyboard(void) {
 #ifdef HAPTIC_ENABLE
     haptic_shutdown();
 #endif
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    // Don't lose keycodes still waiting to be written back
+    dynamic_keymap_flush();
+#endif
+    // Write settings still deferred by eeconfig_mark_dirty()
+    eeconfig_flush();
     bootloader_jump();
 }
 
@@ -432,6 +438,164 @@ void send_string(const char *str) { send_string_with_delay(str, 0); }
 
 void send_string_P(const char *str) { send_string_with_delay_P(str, 0); }
 
+// Modifiers send_char() needs held for a character
+static uint8_t send_char_mods(char ascii_code) {
+    uint8_t mods = 0;
+    if (PGM_LOADBIT(ascii_to_shift_lut, (uint8_t)ascii_code)) {
+        mods |= MOD_BIT(KC_LSFT);
+    }
+    if (PGM_LOADBIT(ascii_to_altgr_lut, (uint8_t)ascii_code)) {
+        mods |= MOD_BIT(KC_RALT);
+    }
+    return mods;
+}
+
+#ifdef SEND_STRING_NONBLOCKING
+#    ifndef SEND_STRING_QUEUE_SIZE
+#        define SEND_STRING_QUEUE_SIZE 64
+#    endif
+
+// Most characters needing the same modifiers typed by one call to send_string_task()
+#    ifndef SEND_STRING_MODS_RUN
+#        define SEND_STRING_MODS_RUN 8
+#    endif
+
+// Characters waiting to be sent, each with the interval to wait after it
+static struct {
+    char    ascii_code;
+    uint8_t interval;
+} send_string_queue[SEND_STRING_QUEUE_SIZE];
+static uint16_t send_string_head  = 0;
+static uint16_t send_string_count = 0;
+static uint32_t send_string_timer = 0;
+static uint32_t send_string_wait  = 0;
+// Modifiers held for the characters being typed, always released before send_string_task() returns
+static uint8_t send_string_mods = 0;
+
+static char send_string_pop(void) {
+    char ascii_code  = send_string_queue[send_string_head].ascii_code;
+    send_string_head = (send_string_head + 1) % SEND_STRING_QUEUE_SIZE;
+    send_string_count--;
+    return ascii_code;
+}
+
+static void send_string_set_mods(uint8_t mods) {
+    if ((mods & MOD_BIT(KC_LSFT)) && !(send_string_mods & MOD_BIT(KC_LSFT))) {
+        register_code(KC_LSFT);
+    }
+    if ((mods & MOD_BIT(KC_RALT)) && !(send_string_mods & MOD_BIT(KC_RALT))) {
+        register_code(KC_RALT);
+    }
+    if (!(mods & MOD_BIT(KC_RALT)) && (send_string_mods & MOD_BIT(KC_RALT))) {
+        unregister_code(KC_RALT);
+    }
+    if (!(mods & MOD_BIT(KC_LSFT)) && (send_string_mods & MOD_BIT(KC_LSFT))) {
+        unregister_code(KC_LSFT);
+    }
+    send_string_mods = mods;
+}
+
+static void send_string_char(char ascii_code) {
+#    if defined(AUDIO_ENABLE) && defined(SENDSTRING_BELL)
+    if (ascii_code == '\a') {  // BEL
+        send_string_set_mods(0);
+        PLAY_SONG(bell_song);
+        return;
+    }
+#    endif
+
+    send_string_set_mods(send_char_mods(ascii_code));
+    tap_code(pgm_read_byte(&ascii_to_keycode_lut[(uint8_t)ascii_code]));
+}
+
+/** \brief Send string task
+ *
+ * Sends the next queued character or key code once the previous one's delay has passed.
+ */
+void send_string_task(void) {
+    if (send_string_wait && timer_elapsed32(send_string_timer) < send_string_wait) {
+        return;
+    }
+    send_string_wait = 0;
+    if (send_string_count == 0) {
+        return;
+    }
+
+    uint8_t interval   = send_string_queue[send_string_head].interval;
+    char    ascii_code = send_string_pop();
+    // Strings are queued whole, so the rest of a key code sequence is always queued
+    if (ascii_code == SS_QMK_PREFIX) {
+        ascii_code = send_string_pop();
+        if (ascii_code == SS_TAP_CODE) {
+            // tap
+            tap_code(send_string_pop());
+        } else if (ascii_code == SS_DOWN_CODE) {
+            // down
+            register_code(send_string_pop());
+        } else if (ascii_code == SS_UP_CODE) {
+            // up
+            unregister_code(send_string_pop());
+        } else if (ascii_code == SS_DELAY_CODE) {
+            // delay
+            uint8_t keycode = send_string_pop();
+            while (isdigit(keycode)) {
+                send_string_wait *= 10;
+                send_string_wait += keycode - '0';
+                keycode = send_string_pop();
+            }
+        }
+    } else {
+        send_string_char(ascii_code);
+        // Type the rest of a run of characters needing the same modifiers now, so they are
+        // pressed once without being left held while the matrix is scanned in between
+        for (uint8_t run = 1; run < SEND_STRING_MODS_RUN && send_string_mods && interval == 0 && send_string_count > 0; run++) {
+            char next = send_string_queue[send_string_head].ascii_code;
+            if (next == SS_QMK_PREFIX || send_char_mods(next) != send_string_mods) {
+                break;
+            }
+            interval = send_string_queue[send_string_head].interval;
+            send_string_char(send_string_pop());
+        }
+        send_string_set_mods(0);
+    }
+    send_string_wait += interval;
+    send_string_timer = timer_read32();
+}
+
+/** \brief Send string flush
+ *
+ * Types everything queued before returning, for code that has to follow the queued strings.
+ */
+void send_string_flush(void) {
+    while (send_string_count > 0 || send_string_wait) {
+        send_string_task();
+    }
+}
+
+static void send_string_push(char ascii_code, uint8_t interval) {
+    // Out of room, so wait for the queue to drain
+    while (send_string_count == SEND_STRING_QUEUE_SIZE) {
+        send_string_task();
+    }
+    uint16_t tail                      = (send_string_head + send_string_count) % SEND_STRING_QUEUE_SIZE;
+    send_string_queue[tail].ascii_code = ascii_code;
+    send_string_queue[tail].interval   = interval;
+    send_string_count++;
+}
+
+void send_string_with_delay(const char *str, uint8_t interval) {
+    while (*str) {
+        send_string_push(*str++, interval);
+    }
+}
+
+void send_string_with_delay_P(const char *str, uint8_t interval) {
+    char ascii_code;
+    while ((ascii_code = pgm_read_byte(str++))) {
+        send_string_push(ascii_code, interval);
+    }
+}
+#else
 void send_string_with_delay(const char *str, uint8_t interval) {
     while (1) {
         char ascii_code = *str;
@@ -514,6 +678,9 @@ void send_string_with_delay_P(const char *str, uint8_t interval) {
     }
 }
 
+void send_string_flush(void) {}
+#endif
+
 void send_char(char ascii_code) {
 #if defined(AUDIO_ENABLE) && defined(SENDSTRING_BELL)
     if (ascii_code == '\a') {  // BEL
@@ -523,8 +690,9 @@ void send_char(char ascii_code) {
 #endif
 
     uint8_t keycode    = pgm_read_byte(&ascii_to_keycode_lut[(uint8_t)ascii_code]);
-    bool    is_shifted = PGM_LOADBIT(ascii_to_shift_lut, (uint8_t)ascii_code);
-    bool    is_altgred = PGM_LOADBIT(ascii_to_altgr_lut, (uint8_t)ascii_code);
+    uint8_t mods       = send_char_mods(ascii_code);
+    bool    is_shifted = mods & MOD_BIT(KC_LSFT);
+    bool    is_altgred = mods & MOD_BIT(KC_RALT);
 
     if (is_shifted) {
         register_code(KC_LSFT);
@@ -661,6 +829,18 @@ void matrix_scan_quantum() {
     dip_switch_read(false);
 #endif
 
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    dynamic_keymap_task();
+#endif
+
+#ifdef SEND_STRING_NONBLOCKING
+    send_string_task();
+#endif
+
+#ifdef TELEMETRY_ENABLE
+    telemetry_task();
+#endif
+
     matrix_scan_kb();
 }
 
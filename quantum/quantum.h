@@ -186,6 +186,10 @@ extern layer_state_t layer_state;
 #    include "wpm.h"
 #endif
 
+#ifdef TELEMETRY_ENABLE
+#    include "telemetry.h"
+#endif
+
 // Function substitutions to ease GPIO manipulation
 #if defined(__AVR__)
 typedef uint8_t pin_t;
@@ -244,6 +248,11 @@ void send_string_with_delay(const char *str, uint8_t interval);
 void send_string_P(const char *str);
 void send_string_with_delay_P(const char *str, uint8_t interval);
 void send_char(char ascii_code);
+// Blocks until queued strings have been typed, does nothing unless SEND_STRING_NONBLOCKING is defined
+void send_string_flush(void);
+#ifdef SEND_STRING_NONBLOCKING
+void send_string_task(void);
+#endif
 
 // For tri-layer
 void          update_tri_layer(uint8_t layer1, uint8_t layer2, uint8_t layer3);
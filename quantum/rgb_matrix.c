@@ -31,6 +31,23 @@ const point_t k_rgb_matrix_center = {112, 32};
 const point_t k_rgb_matrix_center = RGB_MATRIX_CENTER;
 #endif
 
+void rgb_matrix_batch_flush(hsv_batch_t *batch) {
+    RGB rgb[RGB_MATRIX_HSV_BATCH_SIZE];
+    hsv_to_rgb_batch(batch->hsv, rgb, batch->count);
+    for (uint8_t i = 0; i < batch->count; i++) {
+        rgb_matrix_set_color(batch->index[i], rgb[i].r, rgb[i].g, rgb[i].b);
+    }
+    batch->count = 0;
+}
+
+void rgb_matrix_batch_hsv(hsv_batch_t *batch, uint8_t index, HSV hsv) {
+    batch->index[batch->count] = index;
+    batch->hsv[batch->count]   = hsv;
+    if (++batch->count == RGB_MATRIX_HSV_BATCH_SIZE) {
+        rgb_matrix_batch_flush(batch);
+    }
+}
+
 // Generic effect runners
 #include "rgb_matrix_runners/effect_runner_dx_dy_dist.h"
 #include "rgb_matrix_runners/effect_runner_dx_dy.h"
@@ -41,7 +58,7 @@ const point_t k_rgb_matrix_center = RGB_MATRIX_CENTER;
 
 // ------------------------------------------
 // -----Begin rgb effect includes macros-----
-#define RGB_MATRIX_EFFECT(name)
+#define RGB_MATRIX_EFFECT(name, ...)
 #define RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 #include "rgb_matrix_animations/rgb_matrix_effects.inc"
@@ -74,6 +91,14 @@ const point_t k_rgb_matrix_center = RGB_MATRIX_CENTER;
 #    define RGB_MATRIX_MAXIMUM_BRIGHTNESS UINT8_MAX
 #endif
 
+#if !defined(RGB_MATRIX_POWER_BUDGET)
+#    define RGB_MATRIX_POWER_BUDGET 0
+#endif
+
+#if RGB_MATRIX_POWER_BUDGET > 0 || defined(RGB_GAMMA_CORRECTION)
+#    define RGB_MATRIX_POST_PROCESS
+#endif
+
 #if !defined(RGB_MATRIX_HUE_STEP)
 #    define RGB_MATRIX_HUE_STEP 8
 #endif
@@ -122,6 +147,9 @@ uint32_t     g_rgb_timer;
 #ifdef RGB_MATRIX_FRAMEBUFFER_EFFECTS
 uint8_t g_rgb_frame_buffer[MATRIX_ROWS][MATRIX_COLS] = {{0}};
 #endif  // RGB_MATRIX_FRAMEBUFFER_EFFECTS
+#ifdef RGB_MATRIX_POST_PROCESS
+static RGB rgb_frame[DRIVER_LED_TOTAL];
+#endif  // RGB_MATRIX_POST_PROCESS
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 last_hit_t g_last_hit_tracker;
 #endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
@@ -141,9 +169,9 @@ static uint32_t rgb_timer_buffer;
 static last_hit_t last_hit_buffer;
 #endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
 
-void eeconfig_read_rgb_matrix(void) { eeprom_read_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
+void eeconfig_read_rgb_matrix(void) { eeconfig_read_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
 
-void eeconfig_update_rgb_matrix(void) { eeprom_update_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
+void eeconfig_update_rgb_matrix(void) { eeconfig_update_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
 
 void eeconfig_update_rgb_matrix_default(void) {
     dprintf("eeconfig_update_rgb_matrix_default\n");
@@ -176,11 +204,62 @@ uint8_t rgb_matrix_map_row_column_to_led(uint8_t row, uint8_t column, uint8_t *l
     return led_count;
 }
 
-void rgb_matrix_update_pwm_buffers(void) { rgb_matrix_driver.flush(); }
+#ifdef RGB_MATRIX_POST_PROCESS
+static inline uint8_t rgb_matrix_gamma(uint8_t value) {
+#    ifdef RGB_GAMMA_CORRECTION
+    return rgb_gamma_correct(value);
+#    else
+    return value;
+#    endif
+}
+
+// Apply the power budget to the rendered frame, which is already gamma corrected, and hand it to the driver
+static void rgb_matrix_post_process(void) {
+    uint32_t channel_sum = 0;
+#    if RGB_MATRIX_POWER_BUDGET > 0
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        channel_sum += rgb_frame[i].r + rgb_frame[i].g + rgb_frame[i].b;
+    }
+#    endif
+    uint16_t scale = rgb_power_limit_scale(channel_sum, RGB_MATRIX_POWER_BUDGET);
 
-void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) { rgb_matrix_driver.set_color(index, red, green, blue); }
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        uint8_t r = (rgb_frame[i].r * scale) >> 8;
+        uint8_t g = (rgb_frame[i].g * scale) >> 8;
+        uint8_t b = (rgb_frame[i].b * scale) >> 8;
+        rgb_matrix_driver.set_color(i, r, g, b);
+    }
+}
+#endif  // RGB_MATRIX_POST_PROCESS
 
-void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue) { rgb_matrix_driver.set_color_all(red, green, blue); }
+void rgb_matrix_update_pwm_buffers(void) {
+#ifdef RGB_MATRIX_POST_PROCESS
+    rgb_matrix_post_process();
+#endif  // RGB_MATRIX_POST_PROCESS
+    rgb_matrix_driver.flush();
+}
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
+#ifdef RGB_MATRIX_POST_PROCESS
+    if (index < 0 || index >= DRIVER_LED_TOTAL) return;
+    // Gamma is applied once here, so the power budget and the output both use the corrected values
+    rgb_frame[index].r = rgb_matrix_gamma(red);
+    rgb_frame[index].g = rgb_matrix_gamma(green);
+    rgb_frame[index].b = rgb_matrix_gamma(blue);
+#else
+    rgb_matrix_driver.set_color(index, red, green, blue);
+#endif  // RGB_MATRIX_POST_PROCESS
+}
+
+void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
+#ifdef RGB_MATRIX_POST_PROCESS
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        rgb_matrix_set_color(i, red, green, blue);
+    }
+#else
+    rgb_matrix_driver.set_color_all(red, green, blue);
+#endif  // RGB_MATRIX_POST_PROCESS
+}
 
 bool process_rgb_matrix(uint16_t keycode, keyrecord_t *record) {
 #if RGB_DISABLE_TIMEOUT > 0
@@ -262,6 +341,52 @@ static bool rgb_matrix_none(effect_params_t *params) {
     return false;
 }
 
+#ifdef RGB_MATRIX_EFFECT_NAMES
+// ------------------------------------------
+// -----Begin rgb effect name macros---------
+#    define RGB_MATRIX_EFFECT(name, ...) static const char rgb_matrix_effect_name_##name[] PROGMEM = #name;
+#    include "rgb_matrix_animations/rgb_matrix_effects.inc"
+#    ifdef RGB_MATRIX_CUSTOM_KB
+#        include "rgb_matrix_kb.inc"
+#    endif
+#    ifdef RGB_MATRIX_CUSTOM_USER
+#        include "rgb_matrix_user.inc"
+#    endif
+#    undef RGB_MATRIX_EFFECT
+// -----End rgb effect name macros-----------
+// ------------------------------------------
+static const char rgb_matrix_effect_name_NONE[] PROGMEM = "NONE";
+#    define RGB_MATRIX_EFFECT_NAME(effect) .name = rgb_matrix_effect_name_##effect,
+#else
+#    define RGB_MATRIX_EFFECT_NAME(effect)
+#endif
+
+// Effect table indexed by enum rgb_matrix_effects. Everything after the name in
+// RGB_MATRIX_EFFECT initializes the rest of the entry, either a flush limit that
+// overrides RGB_MATRIX_LED_FLUSH_LIMIT or designated .runner and .flags fields
+static const rgb_matrix_effect_t rgb_matrix_effects[] PROGMEM = {
+    [RGB_MATRIX_NONE] = {RGB_MATRIX_EFFECT_NAME(NONE).func = &rgb_matrix_none, .flags = RGB_MATRIX_EFFECT_STATIC},
+
+// ------------------------------------------
+// -----Begin rgb effect table macros--------
+#define RGB_MATRIX_EFFECT(name, ...) [RGB_MATRIX_##name] = {RGB_MATRIX_EFFECT_NAME(name).func = &name, __VA_ARGS__},
+#include "rgb_matrix_animations/rgb_matrix_effects.inc"
+#undef RGB_MATRIX_EFFECT
+
+#if defined(RGB_MATRIX_CUSTOM_KB) || defined(RGB_MATRIX_CUSTOM_USER)
+#    define RGB_MATRIX_EFFECT(name, ...) [RGB_MATRIX_CUSTOM_##name] = {RGB_MATRIX_EFFECT_NAME(name).func = &name, __VA_ARGS__},
+#    ifdef RGB_MATRIX_CUSTOM_KB
+#        include "rgb_matrix_kb.inc"
+#    endif
+#    ifdef RGB_MATRIX_CUSTOM_USER
+#        include "rgb_matrix_user.inc"
+#    endif
+#    undef RGB_MATRIX_EFFECT
+#endif
+    // -----End rgb effect table macros----------
+    // ------------------------------------------
+};
+
 static void rgb_task_timers(void) {
 #if defined(RGB_MATRIX_KEYREACTIVE_ENABLED) || RGB_DISABLE_TIMEOUT > 0
     uint32_t deltaTime = timer_elapsed32(rgb_timer_buffer);
@@ -292,9 +417,12 @@ static void rgb_task_timers(void) {
 #endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
 }
 
-static void rgb_task_sync(void) {
+static void rgb_task_sync(uint8_t effect) {
+    uint8_t flush_limit = effect < RGB_MATRIX_EFFECT_MAX ? pgm_read_byte(&rgb_matrix_effects[effect].flush_limit) : 0;
+    if (!flush_limit) flush_limit = RGB_MATRIX_LED_FLUSH_LIMIT;
+
     // next task
-    if (timer_elapsed32(g_rgb_timer) >= RGB_MATRIX_LED_FLUSH_LIMIT) rgb_task_state = STARTING;
+    if (timer_elapsed32(g_rgb_timer) >= flush_limit) rgb_task_state = STARTING;
 }
 
 static void rgb_task_start(void) {
@@ -315,44 +443,18 @@ static void rgb_task_render(uint8_t effect) {
     bool rendering         = false;
     rgb_effect_params.init = (effect != rgb_last_effect) || (rgb_matrix_config.enable != rgb_last_enable);
 
+    // Factory default magic value
+    if (effect == UINT8_MAX) {
+        rgb_matrix_test();
+        rgb_task_state = FLUSHING;
+        return;
+    }
+
     // each effect can opt to do calculations
     // and/or request PWM buffer updates.
-    switch (effect) {
-        case RGB_MATRIX_NONE:
-            rendering = rgb_matrix_none(&rgb_effect_params);
-            break;
-
-// ---------------------------------------------
-// -----Begin rgb effect switch case macros-----
-#define RGB_MATRIX_EFFECT(name, ...)          \
-    case RGB_MATRIX_##name:                   \
-        rendering = name(&rgb_effect_params); \
-        break;
-#include "rgb_matrix_animations/rgb_matrix_effects.inc"
-#undef RGB_MATRIX_EFFECT
-
-#if defined(RGB_MATRIX_CUSTOM_KB) || defined(RGB_MATRIX_CUSTOM_USER)
-#    define RGB_MATRIX_EFFECT(name, ...)          \
-        case RGB_MATRIX_CUSTOM_##name:            \
-            rendering = name(&rgb_effect_params); \
-            break;
-#    ifdef RGB_MATRIX_CUSTOM_KB
-#        include "rgb_matrix_kb.inc"
-#    endif
-#    ifdef RGB_MATRIX_CUSTOM_USER
-#        include "rgb_matrix_user.inc"
-#    endif
-#    undef RGB_MATRIX_EFFECT
-#endif
-            // -----End rgb effect switch case macros-------
-            // ---------------------------------------------
-
-        // Factory default magic value
-        case UINT8_MAX: {
-            rgb_matrix_test();
-            rgb_task_state = FLUSHING;
-        }
-            return;
+    if (effect < RGB_MATRIX_EFFECT_MAX) {
+        rgb_matrix_effect_f effect_func = (rgb_matrix_effect_f)pgm_read_ptr(&rgb_matrix_effects[effect].func);
+        rendering                       = effect_func(&rgb_effect_params);
     }
 
     rgb_effect_params.iter++;
@@ -406,7 +508,7 @@ void rgb_matrix_task(void) {
             rgb_task_flush(effect);
             break;
         case SYNCING:
-            rgb_task_sync();
+            rgb_task_sync(effect);
             break;
     }
 
@@ -466,7 +568,7 @@ void rgb_matrix_toggle_eeprom_helper(bool write_to_eeprom) {
     rgb_matrix_config.enable ^= 1;
     rgb_task_state = STARTING;
     if (write_to_eeprom) {
-        eeconfig_update_rgb_matrix();
+        eeconfig_mark_dirty(eeconfig_update_rgb_matrix);
     }
     dprintf("rgb matrix toggle [%s]: rgb_matrix_config.enable = %u\n", (write_to_eeprom) ? "EEPROM" : "NOEEPROM", rgb_matrix_config.enable);
 }
@@ -475,7 +577,7 @@ void rgb_matrix_toggle(void) { rgb_matrix_toggle_eeprom_helper(true); }
 
 void rgb_matrix_enable(void) {
     rgb_matrix_enable_noeeprom();
-    eeconfig_update_rgb_matrix();
+    eeconfig_mark_dirty(eeconfig_update_rgb_matrix);
 }
 
 void rgb_matrix_enable_noeeprom(void) {
@@ -485,7 +587,7 @@ void rgb_matrix_enable_noeeprom(void) {
 
 void rgb_matrix_disable(void) {
     rgb_matrix_disable_noeeprom();
-    eeconfig_update_rgb_matrix();
+    eeconfig_mark_dirty(eeconfig_update_rgb_matrix);
 }
 
 void rgb_matrix_disable_noeeprom(void) {
@@ -508,7 +610,7 @@ void rgb_matrix_mode_eeprom_helper(uint8_t mode, bool write_to_eeprom) {
     }
     rgb_task_state = STARTING;
     if (write_to_eeprom) {
-        eeconfig_update_rgb_matrix();
+        eeconfig_mark_dirty(eeconfig_update_rgb_matrix);
     }
     dprintf("rgb matrix mode [%s]: %u\n", (write_to_eeprom) ? "EEPROM" : "NOEEPROM", rgb_matrix_config.mode);
 }
@@ -517,6 +619,14 @@ void rgb_matrix_mode(uint8_t mode) { rgb_matrix_mode_eeprom_helper(mode, true);
 
 uint8_t rgb_matrix_get_mode(void) { return rgb_matrix_config.mode; }
 
+uint8_t rgb_matrix_get_effect_runner(uint8_t mode) { return mode < RGB_MATRIX_EFFECT_MAX ? pgm_read_byte(&rgb_matrix_effects[mode].runner) : RGB_MATRIX_RUNNER_CUSTOM; }
+
+uint8_t rgb_matrix_get_effect_flags(uint8_t mode) { return mode < RGB_MATRIX_EFFECT_MAX ? pgm_read_byte(&rgb_matrix_effects[mode].flags) : 0; }
+
+#ifdef RGB_MATRIX_EFFECT_NAMES
+const char *rgb_matrix_get_effect_name(uint8_t mode) { return mode < RGB_MATRIX_EFFECT_MAX ? (const char *)pgm_read_ptr(&rgb_matrix_effects[mode].name) : NULL; }
+#endif
+
 void rgb_matrix_step_helper(bool write_to_eeprom) {
     uint8_t mode = rgb_matrix_config.mode + 1;
     rgb_matrix_mode_eeprom_helper((mode < RGB_MATRIX_EFFECT_MAX) ? mode : 1, write_to_eeprom);
@@ -539,7 +649,7 @@ void rgb_matrix_sethsv_eeprom_helper(uint16_t hue, uint8_t sat, uint8_t val, boo
     rgb_matrix_config.hsv.s = sat;
     rgb_matrix_config.hsv.v = (val > RGB_MATRIX_MAXIMUM_BRIGHTNESS) ? RGB_MATRIX_MAXIMUM_BRIGHTNESS : val;
     if (write_to_eeprom) {
-        eeconfig_update_rgb_matrix();
+        eeconfig_mark_dirty(eeconfig_update_rgb_matrix);
     }
     dprintf("rgb matrix set hsv [%s]: %u,%u,%u\n", (write_to_eeprom) ? "EEPROM" : "NOEEPROM", rgb_matrix_config.hsv.h, rgb_matrix_config.hsv.s, rgb_matrix_config.hsv.v);
 }
@@ -578,7 +688,7 @@ void rgb_matrix_decrease_val(void) { rgb_matrix_decrease_val_helper(true); }
 void rgb_matrix_set_speed_eeprom_helper(uint8_t speed, bool write_to_eeprom) {
     rgb_matrix_config.speed = speed;
     if (write_to_eeprom) {
-        eeconfig_update_rgb_matrix();
+        eeconfig_mark_dirty(eeconfig_update_rgb_matrix);
     }
     dprintf("rgb matrix set speed [%s]: %u\n", (write_to_eeprom) ? "EEPROM" : "NOEEPROM", rgb_matrix_config.speed);
 }
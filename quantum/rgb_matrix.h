@@ -93,6 +93,10 @@ uint8_t rgb_matrix_map_row_column_to_led(uint8_t row, uint8_t column, uint8_t *l
 void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue);
 void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue);
 
+// Queue a color for an led, converted to RGB together with the rest of the batch
+void rgb_matrix_batch_hsv(hsv_batch_t *batch, uint8_t index, HSV hsv);
+void rgb_matrix_batch_flush(hsv_batch_t *batch);
+
 bool process_rgb_matrix(uint16_t keycode, keyrecord_t *record);
 
 void rgb_matrix_task(void);
@@ -117,6 +121,8 @@ uint8_t     rgb_matrix_is_enabled(void);
 void        rgb_matrix_mode(uint8_t mode);
 void        rgb_matrix_mode_noeeprom(uint8_t mode);
 uint8_t     rgb_matrix_get_mode(void);
+uint8_t     rgb_matrix_get_effect_runner(uint8_t mode);
+uint8_t     rgb_matrix_get_effect_flags(uint8_t mode);
 void        rgb_matrix_step(void);
 void        rgb_matrix_step_noeeprom(void);
 void        rgb_matrix_step_reverse(void);
@@ -148,6 +154,10 @@ void        rgb_matrix_decrease_speed(void);
 void        rgb_matrix_decrease_speed_noeeprom(void);
 led_flags_t rgb_matrix_get_flags(void);
 void        rgb_matrix_set_flags(led_flags_t flags);
+#ifdef RGB_MATRIX_EFFECT_NAMES
+// Returns the name of an effect as a PROGMEM string, or NULL for an invalid mode
+const char *rgb_matrix_get_effect_name(uint8_t mode);
+#endif
 
 #ifndef RGBLIGHT_ENABLE
 #    define rgblight_toggle rgb_matrix_toggle
@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_ALPHAS_MODS
-RGB_MATRIX_EFFECT(ALPHAS_MODS)
+RGB_MATRIX_EFFECT(ALPHAS_MODS, .flags = RGB_MATRIX_EFFECT_STATIC)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 // alphas = color1, mods = color2
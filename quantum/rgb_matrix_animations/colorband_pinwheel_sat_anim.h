@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_BAND_PINWHEEL_SAT
-RGB_MATRIX_EFFECT(BAND_PINWHEEL_SAT)
+RGB_MATRIX_EFFECT(BAND_PINWHEEL_SAT, .runner = RGB_MATRIX_RUNNER_DX_DY)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV BAND_PINWHEEL_SAT_math(HSV hsv, int16_t dx, int16_t dy, uint8_t time) {
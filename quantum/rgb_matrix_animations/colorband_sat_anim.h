@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_BAND_SAT
-RGB_MATRIX_EFFECT(BAND_SAT)
+RGB_MATRIX_EFFECT(BAND_SAT, .runner = RGB_MATRIX_RUNNER_I)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV BAND_SAT_math(HSV hsv, uint8_t i, uint8_t time) {
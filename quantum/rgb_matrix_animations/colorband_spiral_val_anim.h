@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_BAND_SPIRAL_VAL
-RGB_MATRIX_EFFECT(BAND_SPIRAL_VAL)
+RGB_MATRIX_EFFECT(BAND_SPIRAL_VAL, .runner = RGB_MATRIX_RUNNER_DX_DY_DIST)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV BAND_SPIRAL_VAL_math(HSV hsv, int16_t dx, int16_t dy, uint8_t dist, uint8_t time) {
@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_CYCLE_ALL
-RGB_MATRIX_EFFECT(CYCLE_ALL)
+RGB_MATRIX_EFFECT(CYCLE_ALL, .runner = RGB_MATRIX_RUNNER_I)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV CYCLE_ALL_math(HSV hsv, uint8_t i, uint8_t time) {
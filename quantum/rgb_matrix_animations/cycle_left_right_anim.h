@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_CYCLE_LEFT_RIGHT
-RGB_MATRIX_EFFECT(CYCLE_LEFT_RIGHT)
+RGB_MATRIX_EFFECT(CYCLE_LEFT_RIGHT, .runner = RGB_MATRIX_RUNNER_I)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV CYCLE_LEFT_RIGHT_math(HSV hsv, uint8_t i, uint8_t time) {
@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_CYCLE_OUT_IN
-RGB_MATRIX_EFFECT(CYCLE_OUT_IN)
+RGB_MATRIX_EFFECT(CYCLE_OUT_IN, .runner = RGB_MATRIX_RUNNER_DX_DY_DIST)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV CYCLE_OUT_IN_math(HSV hsv, int16_t dx, int16_t dy, uint8_t dist, uint8_t time) {
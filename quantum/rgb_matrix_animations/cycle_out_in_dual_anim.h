@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_CYCLE_OUT_IN_DUAL
-RGB_MATRIX_EFFECT(CYCLE_OUT_IN_DUAL)
+RGB_MATRIX_EFFECT(CYCLE_OUT_IN_DUAL, .runner = RGB_MATRIX_RUNNER_DX_DY)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV CYCLE_OUT_IN_DUAL_math(HSV hsv, int16_t dx, int16_t dy, uint8_t time) {
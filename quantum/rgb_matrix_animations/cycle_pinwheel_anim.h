@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_CYCLE_PINWHEEL
-RGB_MATRIX_EFFECT(CYCLE_PINWHEEL)
+RGB_MATRIX_EFFECT(CYCLE_PINWHEEL, .runner = RGB_MATRIX_RUNNER_DX_DY)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV CYCLE_PINWHEEL_math(HSV hsv, int16_t dx, int16_t dy, uint8_t time) {
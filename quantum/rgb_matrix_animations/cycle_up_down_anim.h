@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_CYCLE_UP_DOWN
-RGB_MATRIX_EFFECT(CYCLE_UP_DOWN)
+RGB_MATRIX_EFFECT(CYCLE_UP_DOWN, .runner = RGB_MATRIX_RUNNER_I)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV CYCLE_UP_DOWN_math(HSV hsv, uint8_t i, uint8_t time) {
@@ -1,5 +1,5 @@
 #if defined(RGB_MATRIX_FRAMEBUFFER_EFFECTS) && !defined(DISABLE_RGB_MATRIX_DIGITAL_RAIN)
-RGB_MATRIX_EFFECT(DIGITAL_RAIN)
+RGB_MATRIX_EFFECT(DIGITAL_RAIN, .flags = RGB_MATRIX_EFFECT_FRAMEBUFFER)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 #        ifndef RGB_DIGITAL_RAIN_DROPS
@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_DUAL_BEACON
-RGB_MATRIX_EFFECT(DUAL_BEACON)
+RGB_MATRIX_EFFECT(DUAL_BEACON, .runner = RGB_MATRIX_RUNNER_SIN_COS_I)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV DUAL_BEACON_math(HSV hsv, int8_t sin, int8_t cos, uint8_t i, uint8_t time) {
@@ -1,20 +1,22 @@
 #ifndef DISABLE_RGB_MATRIX_GRADIENT_LEFT_RIGHT
-RGB_MATRIX_EFFECT(GRADIENT_LEFT_RIGHT)
+RGB_MATRIX_EFFECT(GRADIENT_LEFT_RIGHT, .flags = RGB_MATRIX_EFFECT_STATIC)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 bool GRADIENT_LEFT_RIGHT(effect_params_t* params) {
     RGB_MATRIX_USE_LIMITS(led_min, led_max);
 
+    hsv_batch_t batch = {0};
+
     HSV     hsv   = rgb_matrix_config.hsv;
     uint8_t scale = scale8(64, rgb_matrix_config.speed);
     for (uint8_t i = led_min; i < led_max; i++) {
         RGB_MATRIX_TEST_LED_FLAGS();
         // The x range will be 0..224, map this to 0..7
         // Relies on hue being 8-bit and wrapping
-        hsv.h   = rgb_matrix_config.hsv.h + (scale * g_led_config.point[i].x >> 5);
-        RGB rgb = hsv_to_rgb(hsv);
-        rgb_matrix_set_color(i, rgb.r, rgb.g, rgb.b);
+        hsv.h = rgb_matrix_config.hsv.h + (scale * g_led_config.point[i].x >> 5);
+        rgb_matrix_batch_hsv(&batch, i, hsv);
     }
+    rgb_matrix_batch_flush(&batch);
     return led_max < DRIVER_LED_TOTAL;
 }
 
@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_RAINBOW_BEACON
-RGB_MATRIX_EFFECT(RAINBOW_BEACON)
+RGB_MATRIX_EFFECT(RAINBOW_BEACON, .runner = RGB_MATRIX_RUNNER_SIN_COS_I)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV RAINBOW_BEACON_math(HSV hsv, int8_t sin, int8_t cos, uint8_t i, uint8_t time) {
@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_RAINBOW_MOVING_CHEVRON
-RGB_MATRIX_EFFECT(RAINBOW_MOVING_CHEVRON)
+RGB_MATRIX_EFFECT(RAINBOW_MOVING_CHEVRON, .runner = RGB_MATRIX_RUNNER_I)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV RAINBOW_MOVING_CHEVRON_math(HSV hsv, uint8_t i, uint8_t time) {
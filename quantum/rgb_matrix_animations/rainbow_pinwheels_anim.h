@@ -1,5 +1,5 @@
 #ifndef DISABLE_RGB_MATRIX_RAINBOW_PINWHEELS
-RGB_MATRIX_EFFECT(RAINBOW_PINWHEELS)
+RGB_MATRIX_EFFECT(RAINBOW_PINWHEELS, .runner = RGB_MATRIX_RUNNER_SIN_COS_I)
 #    ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV RAINBOW_PINWHEELS_math(HSV hsv, int8_t sin, int8_t cos, uint8_t i, uint8_t time) {
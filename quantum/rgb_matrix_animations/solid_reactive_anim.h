@@ -1,6 +1,6 @@
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 #    ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE
-RGB_MATRIX_EFFECT(SOLID_REACTIVE)
+RGB_MATRIX_EFFECT(SOLID_REACTIVE, .runner = RGB_MATRIX_RUNNER_REACTIVE, .flags = RGB_MATRIX_EFFECT_KEYREACTIVE)
 #        ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
 
 static HSV SOLID_REACTIVE_math(HSV hsv, uint16_t offset) {
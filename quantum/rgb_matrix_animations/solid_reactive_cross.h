@@ -2,11 +2,11 @@
 #    if !defined(DISABLE_RGB_MATRIX_SOLID_REACTIVE_CROSS) || !defined(DISABLE_RGB_MATRIX_SOLID_REACTIVE_MULTICROSS)
 
 #        ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_CROSS
-RGB_MATRIX_EFFECT(SOLID_REACTIVE_CROSS)
+RGB_MATRIX_EFFECT(SOLID_REACTIVE_CROSS, .runner = RGB_MATRIX_RUNNER_REACTIVE_SPLASH, .flags = RGB_MATRIX_EFFECT_KEYREACTIVE)
 #        endif
 
 #        ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_MULTICROSS
-RGB_MATRIX_EFFECT(SOLID_REACTIVE_MULTICROSS)
+RGB_MATRIX_EFFECT(SOLID_REACTIVE_MULTICROSS, .runner = RGB_MATRIX_RUNNER_REACTIVE_SPLASH, .flags = RGB_MATRIX_EFFECT_KEYREACTIVE)
 #        endif
 
 #        ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
@@ -23,12 +23,17 @@ static HSV SOLID_REACTIVE_CROSS_math(HSV hsv, int16_t dx, int16_t dy, uint8_t di
     return hsv;
 }
 
+static int16_t SOLID_REACTIVE_CROSS_reach(uint16_t tick) {
+    if (tick >= UINT8_MAX) return -1;
+    return UINT8_MAX - 1 - tick;
+}
+
 #            ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_CROSS
-bool SOLID_REACTIVE_CROSS(effect_params_t* params) { return effect_runner_reactive_splash(qsub8(g_last_hit_tracker.count, 1), params, &SOLID_REACTIVE_CROSS_math); }
+bool SOLID_REACTIVE_CROSS(effect_params_t* params) { return effect_runner_reactive_splash(qsub8(g_last_hit_tracker.count, 1), params, &SOLID_REACTIVE_CROSS_math, &SOLID_REACTIVE_CROSS_reach); }
 #            endif
 
 #            ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_MULTICROSS
-bool SOLID_REACTIVE_MULTICROSS(effect_params_t* params) { return effect_runner_reactive_splash(0, params, &SOLID_REACTIVE_CROSS_math); }
+bool SOLID_REACTIVE_MULTICROSS(effect_params_t* params) { return effect_runner_reactive_splash(0, params, &SOLID_REACTIVE_CROSS_math, &SOLID_REACTIVE_CROSS_reach); }
 #            endif
 
 #        endif  // RGB_MATRIX_CUSTOM_EFFECT_IMPLS
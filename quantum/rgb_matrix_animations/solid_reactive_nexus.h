@@ -2,11 +2,11 @@
 #    if !defined(DISABLE_RGB_MATRIX_SOLID_REACTIVE_NEXUS) || !defined(DISABLE_RGB_MATRIX_SOLID_REACTIVE_MULTINEXUS)
 
 #        ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_NEXUS
-RGB_MATRIX_EFFECT(SOLID_REACTIVE_NEXUS)
+RGB_MATRIX_EFFECT(SOLID_REACTIVE_NEXUS, .runner = RGB_MATRIX_RUNNER_REACTIVE_SPLASH, .flags = RGB_MATRIX_EFFECT_KEYREACTIVE)
 #        endif
 
 #        ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_MULTINEXUS
-RGB_MATRIX_EFFECT(SOLID_REACTIVE_MULTINEXUS)
+RGB_MATRIX_EFFECT(SOLID_REACTIVE_MULTINEXUS, .runner = RGB_MATRIX_RUNNER_REACTIVE_SPLASH, .flags = RGB_MATRIX_EFFECT_KEYREACTIVE)
 #        endif
 
 #        ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
@@ -16,17 +16,24 @@ static HSV SOLID_REACTIVE_NEXUS_math(HSV hsv, int16_t dx, int16_t dy, uint8_t di
     if (effect > 255) effect = 255;
     if (dist > 72) effect = 255;
     if ((dx > 8 || dx < -8) && (dy > 8 || dy < -8)) effect = 255;
+    // The hue comes from the hits that light the led, the runner skips the rest
+    if (effect == 255) return hsv;
     hsv.v = qadd8(hsv.v, 255 - effect);
     hsv.h = rgb_matrix_config.hsv.h + dy / 4;
     return hsv;
 }
 
+static int16_t SOLID_REACTIVE_NEXUS_reach(uint16_t tick) {
+    if (tick > 72 + UINT8_MAX) return -1;
+    return tick > 72 ? 72 : tick;
+}
+
 #            ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_NEXUS
-bool SOLID_REACTIVE_NEXUS(effect_params_t* params) { return effect_runner_reactive_splash(qsub8(g_last_hit_tracker.count, 1), params, &SOLID_REACTIVE_NEXUS_math); }
+bool SOLID_REACTIVE_NEXUS(effect_params_t* params) { return effect_runner_reactive_splash(qsub8(g_last_hit_tracker.count, 1), params, &SOLID_REACTIVE_NEXUS_math, &SOLID_REACTIVE_NEXUS_reach); }
 #            endif
 
 #            ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_MULTINEXUS
-bool SOLID_REACTIVE_MULTINEXUS(effect_params_t* params) { return effect_runner_reactive_splash(0, params, &SOLID_REACTIVE_NEXUS_math); }
+bool SOLID_REACTIVE_MULTINEXUS(effect_params_t* params) { return effect_runner_reactive_splash(0, params, &SOLID_REACTIVE_NEXUS_math, &SOLID_REACTIVE_NEXUS_reach); }
 #            endif
 
 #        endif  // RGB_MATRIX_CUSTOM_EFFECT_IMPLS
@@ -2,11 +2,11 @@
 #    if !defined(DISABLE_RGB_MATRIX_SOLID_REACTIVE_WIDE) || !defined(DISABLE_RGB_MATRIX_SOLID_REACTIVE_MULTIWIDE)
 
 #        ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_WIDE
-RGB_MATRIX_EFFECT(SOLID_REACTIVE_WIDE)
+RGB_MATRIX_EFFECT(SOLID_REACTIVE_WIDE, .runner = RGB_MATRIX_RUNNER_REACTIVE_SPLASH, .flags = RGB_MATRIX_EFFECT_KEYREACTIVE)
 #        endif
 
 #        ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_MULTIWIDE
-RGB_MATRIX_EFFECT(SOLID_REACTIVE_MULTIWIDE)
+RGB_MATRIX_EFFECT(SOLID_REACTIVE_MULTIWIDE, .runner = RGB_MATRIX_RUNNER_REACTIVE_SPLASH, .flags = RGB_MATRIX_EFFECT_KEYREACTIVE)
 #        endif
 
 #        ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
@@ -18,12 +18,17 @@ static HSV SOLID_REACTIVE_WIDE_math(HSV hsv, int16_t dx, int16_t dy, uint8_t dis
     return hsv;
 }
 
+static int16_t SOLID_REACTIVE_WIDE_reach(uint16_t tick) {
+    if (tick >= UINT8_MAX) return -1;
+    return (UINT8_MAX - 1 - tick) / 5;
+}
+
 #            ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_WIDE
-bool SOLID_REACTIVE_WIDE(effect_params_t* params) { return effect_runner_reactive_splash(qsub8(g_last_hit_tracker.count, 1), params, &SOLID_REACTIVE_WIDE_math); }
+bool SOLID_REACTIVE_WIDE(effect_params_t* params) { return effect_runner_reactive_splash(qsub8(g_last_hit_tracker.count, 1), params, &SOLID_REACTIVE_WIDE_math, &SOLID_REACTIVE_WIDE_reach); }
 #            endif
 
 #            ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE_MULTIWIDE
-bool SOLID_REACTIVE_MULTIWIDE(effect_params_t* params) { return effect_runner_reactive_splash(0, params, &SOLID_REACTIVE_WIDE_math); }
+bool SOLID_REACTIVE_MULTIWIDE(effect_params_t* params) { return effect_runner_reactive_splash(0, params, &SOLID_REACTIVE_WIDE_math, &SOLID_REACTIVE_WIDE_reach); }
 #            endif
 
 #        endif  // RGB_MATRIX_CUSTOM_EFFECT_IMPLS
@@ -2,11 +2,11 @@
 #    if !defined(DISABLE_RGB_MATRIX_SOLID_SPLASH) || !defined(DISABLE_RGB_MATRIX_SOLID_MULTISPLASH)
 
 #        ifndef DISABLE_RGB_MATRIX_SOLID_SPLASH
-RGB_MATRIX_EFFECT(SOLID_SPLASH)
+RGB_MATRIX_EFFECT(SOLID_SPLASH, .runner = RGB_MATRIX_RUNNER_REACTIVE_SPLASH, .flags = RGB_MATRIX_EFFECT_KEYREACTIVE)
 #        endif
 
 #        ifndef DISABLE_RGB_MATRIX_SOLID_MULTISPLASH
-RGB_MATRIX_EFFECT(SOLID_MULTISPLASH)
+RGB_MATRIX_EFFECT(SOLID_MULTISPLASH, .runner = RGB_MATRIX_RUNNER_REACTIVE_SPLASH, .flags = RGB_MATRIX_EFFECT_KEYREACTIVE)
 #        endif
 
 #        ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
@@ -18,12 +18,17 @@ HSV SOLID_SPLASH_math(HSV hsv, int16_t dx, int16_t dy, uint8_t dist, uint16_t ti
     return hsv;
 }
 
+static int16_t SOLID_SPLASH_reach(uint16_t tick) {
+    if (tick > 2 * UINT8_MAX) return -1;
+    return tick > UINT8_MAX ? UINT8_MAX : tick;
+}
+
 #            ifndef DISABLE_RGB_MATRIX_SOLID_SPLASH
-bool SOLID_SPLASH(effect_params_t* params) { return effect_runner_reactive_splash(qsub8(g_last_hit_tracker.count, 1), params, &SOLID_SPLASH_math); }
+bool SOLID_SPLASH(effect_params_t* params) { return effect_runner_reactive_splash(qsub8(g_last_hit_tracker.count, 1), params, &SOLID_SPLASH_math, &SOLID_SPLASH_reach); }
 #            endif
 
 #            ifndef DISABLE_RGB_MATRIX_SOLID_MULTISPLASH
-bool SOLID_MULTISPLASH(effect_params_t* params) { return effect_runner_reactive_splash(0, params, &SOLID_SPLASH_math); }
+bool SOLID_MULTISPLASH(effect_params_t* params) { return effect_runner_reactive_splash(0, params, &SOLID_SPLASH_math, &SOLID_SPLASH_reach); }
 #            endif
 
 #        endif  // RGB_MATRIX_CUSTOM_EFFECT_IMPLS
@@ -2,11 +2,11 @@
 #    if !defined(DISABLE_RGB_MATRIX_SPLASH) || !defined(DISABLE_RGB_MATRIX_MULTISPLASH)
 
 #        ifndef DISABLE_RGB_MATRIX_SPLASH
-RGB_MATRIX_EFFECT(SPLASH)
+RGB_MATRIX_EFFECT(SPLASH, .runner = RGB_MATRIX_RUNNER_REACTIVE_SPLASH, .flags = RGB_MATRIX_EFFECT_KEYREACTIVE)
 #        endif
 
 #        ifndef DISABLE_RGB_MATRIX_MULTISPLASH
-RGB_MATRIX_EFFECT(MULTISPLASH)
+RGB_MATRIX_EFFECT(MULTISPLASH, .runner = RGB_MATRIX_RUNNER_REACTIVE_SPLASH, .flags = RGB_MATRIX_EFFECT_KEYREACTIVE)
 #        endif
 
 #        ifdef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
@@ -14,17 +14,24 @@ RGB_MATRIX_EFFECT(MULTISPLASH)
 HSV SPLASH_math(HSV hsv, int16_t dx, int16_t dy, uint8_t dist, uint16_t tick) {
     uint16_t effect = tick - dist;
     if (effect > 255) effect = 255;
+    // Spent hits don't shift the hue, as the runner doesn't visit those out of reach
+    if (effect == 255) return hsv;
     hsv.h += effect;
     hsv.v = qadd8(hsv.v, 255 - effect);
     return hsv;
 }
 
+static int16_t SPLASH_reach(uint16_t tick) {
+    if (tick > 2 * UINT8_MAX) return -1;
+    return tick > UINT8_MAX ? UINT8_MAX : tick;
+}
+
 #            ifndef DISABLE_RGB_MATRIX_SPLASH
-bool SPLASH(effect_params_t* params) { return effect_runner_reactive_splash(qsub8(g_last_hit_tracker.count, 1), params, &SPLASH_math); }
+bool SPLASH(effect_params_t* params) { return effect_runner_reactive_splash(qsub8(g_last_hit_tracker.count, 1), params, &SPLASH_math, &SPLASH_reach); }
 #            endif
 
 #            ifndef DISABLE_RGB_MATRIX_MULTISPLASH
-bool MULTISPLASH(effect_params_t* params) { return effect_runner_reactive_splash(0, params, &SPLASH_math); }
+bool MULTISPLASH(effect_params_t* params) { return effect_runner_reactive_splash(0, params, &SPLASH_math, &SPLASH_reach); }
 #            endif
 
 #        endif  // RGB_MATRIX_CUSTOM_EFFECT_IMPLS
@@ -3,26 +3,48 @@
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 
 typedef HSV (*reactive_splash_f)(HSV hsv, int16_t dx, int16_t dy, uint8_t dist, uint16_t tick);
+// Returns how far from the hit the effect can currently light leds, or -1 once the hit no longer lights anything.
+// Hits out of reach aren't passed to the effect at all, so it must leave hsv untouched for hits that don't light the led.
+typedef int16_t (*reactive_splash_reach_f)(uint16_t tick);
 
-bool effect_runner_reactive_splash(uint8_t start, effect_params_t* params, reactive_splash_f effect_func) {
+bool effect_runner_reactive_splash(uint8_t start, effect_params_t* params, reactive_splash_f effect_func, reactive_splash_reach_f reach_func) {
     RGB_MATRIX_USE_LIMITS(led_min, led_max);
 
-    uint8_t count = g_last_hit_tracker.count;
+    // Only the hits still lighting something are visited for each led
+    uint8_t  count = 0;
+    uint8_t  x[LED_HITS_TO_REMEMBER];
+    uint8_t  y[LED_HITS_TO_REMEMBER];
+    uint16_t tick[LED_HITS_TO_REMEMBER];
+    int16_t  reach[LED_HITS_TO_REMEMBER];
+    for (uint8_t j = start; j < g_last_hit_tracker.count; j++) {
+        tick[count]  = scale16by8(g_last_hit_tracker.tick[j], rgb_matrix_config.speed);
+        reach[count] = reach_func(tick[count]);
+        if (reach[count] < 0) {
+            continue;
+        }
+        x[count] = g_last_hit_tracker.x[j];
+        y[count] = g_last_hit_tracker.y[j];
+        count++;
+    }
+
+    hsv_batch_t batch = {0};
     for (uint8_t i = led_min; i < led_max; i++) {
         RGB_MATRIX_TEST_LED_FLAGS();
         HSV hsv = rgb_matrix_config.hsv;
         hsv.v   = 0;
-        for (uint8_t j = start; j < count; j++) {
-            int16_t  dx   = g_led_config.point[i].x - g_last_hit_tracker.x[j];
-            int16_t  dy   = g_led_config.point[i].y - g_last_hit_tracker.y[j];
-            uint8_t  dist = sqrt16(dx * dx + dy * dy);
-            uint16_t tick = scale16by8(g_last_hit_tracker.tick[j], rgb_matrix_config.speed);
-            hsv           = effect_func(hsv, dx, dy, dist, tick);
+        for (uint8_t j = 0; j < count; j++) {
+            int16_t dx = g_led_config.point[i].x - x[j];
+            int16_t dy = g_led_config.point[i].y - y[j];
+            if (dx > reach[j] || dx < -reach[j] || dy > reach[j] || dy < -reach[j]) {
+                continue;
+            }
+            uint8_t dist = sqrt16(dx * dx + dy * dy);
+            hsv          = effect_func(hsv, dx, dy, dist, tick[j]);
         }
-        hsv.v   = scale8(hsv.v, rgb_matrix_config.hsv.v);
-        RGB rgb = hsv_to_rgb(hsv);
-        rgb_matrix_set_color(i, rgb.r, rgb.g, rgb.b);
+        hsv.v = scale8(hsv.v, rgb_matrix_config.hsv.v);
+        rgb_matrix_batch_hsv(&batch, i, hsv);
     }
+    rgb_matrix_batch_flush(&batch);
     return led_max < DRIVER_LED_TOTAL;
 }
 
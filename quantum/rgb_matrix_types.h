@@ -48,6 +48,44 @@ typedef struct PACKED {
     uint8_t y;
 } point_t;
 
+// Number of colors converted together by rgb_matrix_batch_hsv
+#ifndef RGB_MATRIX_HSV_BATCH_SIZE
+#    define RGB_MATRIX_HSV_BATCH_SIZE 8
+#endif  // RGB_MATRIX_HSV_BATCH_SIZE
+
+typedef struct PACKED {
+    uint8_t count;
+    uint8_t index[RGB_MATRIX_HSV_BATCH_SIZE];
+    HSV     hsv[RGB_MATRIX_HSV_BATCH_SIZE];
+} hsv_batch_t;
+
+typedef bool (*rgb_matrix_effect_f)(effect_params_t *params);
+
+// Which of the rgb_matrix_runners an effect renders through
+typedef enum rgb_matrix_runner_t {
+    RGB_MATRIX_RUNNER_CUSTOM = 0,
+    RGB_MATRIX_RUNNER_I,
+    RGB_MATRIX_RUNNER_DX_DY,
+    RGB_MATRIX_RUNNER_DX_DY_DIST,
+    RGB_MATRIX_RUNNER_SIN_COS_I,
+    RGB_MATRIX_RUNNER_REACTIVE,
+    RGB_MATRIX_RUNNER_REACTIVE_SPLASH,
+} rgb_matrix_runner_t;
+
+#define RGB_MATRIX_EFFECT_STATIC 0x01       // the output only changes with rgb_matrix_config, not over time
+#define RGB_MATRIX_EFFECT_KEYREACTIVE 0x02  // renders from the key hits of RGB_MATRIX_KEYREACTIVE_ENABLED
+#define RGB_MATRIX_EFFECT_FRAMEBUFFER 0x04  // renders from g_rgb_frame_buffer
+
+typedef struct {
+#ifdef RGB_MATRIX_EFFECT_NAMES
+    const char *name;  // in PROGMEM
+#endif
+    rgb_matrix_effect_f func;
+    uint8_t             flush_limit;  // milliseconds between frames, 0 uses RGB_MATRIX_LED_FLUSH_LIMIT
+    uint8_t             runner;       // rgb_matrix_runner_t
+    uint8_t             flags;        // RGB_MATRIX_EFFECT_*
+} rgb_matrix_effect_t;
+
 #define HAS_FLAGS(bits, flags) ((bits & flags) == flags)
 #define HAS_ANY_FLAGS(bits, flags) ((bits & flags) != 0x00)
 
@@ -156,7 +156,7 @@ void rgblight_check_config(void) {
 
 uint32_t eeconfig_read_rgblight(void) {
 #ifdef EEPROM_ENABLE
-    return eeprom_read_dword(EECONFIG_RGBLIGHT);
+    return eeconfig_read_dword(EECONFIG_RGBLIGHT);
 #else
     return 0;
 #endif
@@ -165,7 +165,7 @@ uint32_t eeconfig_read_rgblight(void) {
 void eeconfig_update_rgblight(uint32_t val) {
 #ifdef EEPROM_ENABLE
     rgblight_check_config();
-    eeprom_update_dword(EECONFIG_RGBLIGHT, val);
+    eeconfig_update_dword(EECONFIG_RGBLIGHT, val);
 #endif
 }
 
@@ -297,7 +297,7 @@ void rgblight_mode_eeprom_helper(uint8_t mode, bool write_to_eeprom) {
     }
     RGBLIGHT_SPLIT_SET_CHANGE_MODE;
     if (write_to_eeprom) {
-        eeconfig_update_rgblight(rgblight_config.raw);
+        eeconfig_mark_dirty(eeconfig_update_rgblight_current);
         dprintf("rgblight mode [EEPROM]: %u\n", rgblight_config.mode);
     } else {
         dprintf("rgblight mode [NOEEPROM]: %u\n", rgblight_config.mode);
@@ -351,7 +351,7 @@ void rgblight_enable_noeeprom(void) {
 
 void rgblight_disable(void) {
     rgblight_config.enable = 0;
-    eeconfig_update_rgblight(rgblight_config.raw);
+    eeconfig_mark_dirty(eeconfig_update_rgblight_current);
     dprintf("rgblight disable [EEPROM]: rgblight_config.enable = %u\n", rgblight_config.enable);
     rgblight_timer_disable();
     RGBLIGHT_SPLIT_SET_CHANGE_MODE;
@@ -411,7 +411,7 @@ void rgblight_increase_speed_helper(bool write_to_eeprom) {
     if (rgblight_config.speed < 3) rgblight_config.speed++;
     // RGBLIGHT_SPLIT_SET_CHANGE_HSVS; // NEED?
     if (write_to_eeprom) {
-        eeconfig_update_rgblight(rgblight_config.raw);  // EECONFIG needs to be increased to support this
+        eeconfig_mark_dirty(eeconfig_update_rgblight_current);  // EECONFIG needs to be increased to support this
     }
 }
 void rgblight_increase_speed(void) { rgblight_increase_speed_helper(true); }
@@ -421,7 +421,7 @@ void rgblight_decrease_speed_helper(bool write_to_eeprom) {
     if (rgblight_config.speed > 0) rgblight_config.speed--;
     // RGBLIGHT_SPLIT_SET_CHANGE_HSVS; // NEED??
     if (write_to_eeprom) {
-        eeconfig_update_rgblight(rgblight_config.raw);  // EECONFIG needs to be increased to support this
+        eeconfig_mark_dirty(eeconfig_update_rgblight_current);  // EECONFIG needs to be increased to support this
     }
 }
 void rgblight_decrease_speed(void) { rgblight_decrease_speed_helper(true); }
@@ -499,7 +499,7 @@ void rgblight_sethsv_eeprom_helper(uint8_t hue, uint8_t sat, uint8_t val, bool w
         rgblight_config.sat = sat;
         rgblight_config.val = val;
         if (write_to_eeprom) {
-            eeconfig_update_rgblight(rgblight_config.raw);
+            eeconfig_mark_dirty(eeconfig_update_rgblight_current);
             dprintf("rgblight set hsv [EEPROM]: %u,%u,%u\n", rgblight_config.hue, rgblight_config.sat, rgblight_config.val);
         } else {
             dprintf("rgblight set hsv [NOEEPROM]: %u,%u,%u\n", rgblight_config.hue, rgblight_config.sat, rgblight_config.val);
@@ -516,7 +516,7 @@ uint8_t rgblight_get_speed(void) { return rgblight_config.speed; }
 void rgblight_set_speed_eeprom_helper(uint8_t speed, bool write_to_eeprom) {
     rgblight_config.speed = speed;
     if (write_to_eeprom) {
-        eeconfig_update_rgblight(rgblight_config.raw);  // EECONFIG needs to be increased to support this
+        eeconfig_mark_dirty(eeconfig_update_rgblight_current);  // EECONFIG needs to be increased to support this
         dprintf("rgblight set speed [EEPROM]: %u\n", rgblight_config.speed);
     } else {
         dprintf("rgblight set speed [NOEEPROM]: %u\n", rgblight_config.speed);
@@ -710,6 +710,35 @@ __attribute__((weak)) void rgblight_call_driver(LED_TYPE *start_led, uint8_t num
 
 #ifndef RGBLIGHT_CUSTOM_DRIVER
 
+#    ifdef RGBLIGHT_POST_PROCESS
+// Apply gamma and the power budget to the copy of the frame sent to the driver
+static void rgblight_post_process(LED_TYPE *start_led, uint8_t num_leds) {
+#        ifdef RGB_GAMMA_CORRECTION
+    for (uint8_t i = 0; i < num_leds; i++) {
+        start_led[i].r = rgb_gamma_correct(start_led[i].r);
+        start_led[i].g = rgb_gamma_correct(start_led[i].g);
+        start_led[i].b = rgb_gamma_correct(start_led[i].b);
+    }
+#        endif
+
+#        if RGBLIGHT_POWER_BUDGET > 0
+    uint32_t channel_sum = 0;
+    for (uint8_t i = 0; i < num_leds; i++) {
+        channel_sum += start_led[i].r + start_led[i].g + start_led[i].b;
+    }
+
+    uint16_t scale = rgb_power_limit_scale(channel_sum, RGBLIGHT_POWER_BUDGET);
+    if (scale < 256) {
+        for (uint8_t i = 0; i < num_leds; i++) {
+            start_led[i].r = (start_led[i].r * scale) >> 8;
+            start_led[i].g = (start_led[i].g * scale) >> 8;
+            start_led[i].b = (start_led[i].b * scale) >> 8;
+        }
+    }
+#        endif
+}
+#    endif
+
 void rgblight_set(void) {
     LED_TYPE *start_led;
     uint8_t   num_leds = rgblight_ranges.clipping_num_leds;
@@ -735,16 +764,24 @@ void rgblight_set(void) {
     }
 #    endif
 
-#    ifdef RGBLIGHT_LED_MAP
+#    if defined(RGBLIGHT_LED_MAP) || defined(RGBLIGHT_POST_PROCESS)
     LED_TYPE led0[RGBLED_NUM];
     for (uint8_t i = 0; i < RGBLED_NUM; i++) {
+#        ifdef RGBLIGHT_LED_MAP
         led0[i] = led[pgm_read_byte(&led_map[i])];
+#        else
+        led0[i] = led[i];
+#        endif
     }
     start_led = led0 + rgblight_ranges.clipping_start_pos;
 #    else
     start_led = led + rgblight_ranges.clipping_start_pos;
 #    endif
 
+#    ifdef RGBLIGHT_POST_PROCESS
+    rgblight_post_process(start_led, num_leds);
+#    endif
+
 #    ifdef RGBW
     for (uint8_t i = 0; i < num_leds; i++) {
         convert_rgb_to_rgbw(&start_led[i]);
@@ -169,6 +169,12 @@ enum RGBLIGHT_EFFECT_MODE {
 #    ifndef RGBLIGHT_LIMIT_VAL
 #        define RGBLIGHT_LIMIT_VAL 255
 #    endif
+#    ifndef RGBLIGHT_POWER_BUDGET
+#        define RGBLIGHT_POWER_BUDGET 0
+#    endif
+#    if RGBLIGHT_POWER_BUDGET > 0 || defined(RGB_GAMMA_CORRECTION)
+#        define RGBLIGHT_POST_PROCESS
+#    endif
 
 #    define RGBLED_TIMER_TOP F_CPU / (256 * 64)
 // #define RGBLED_TIMER_TOP 0xFF10
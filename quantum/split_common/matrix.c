@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "split_util.h"
 #include "config.h"
 #include "transport.h"
+#include "telemetry.h"
 
 #define ERROR_DISCONNECT_COUNT 5
 
@@ -246,6 +247,7 @@ void matrix_post_scan(void) {
 
         if (!transport_master(matrix + thatHand)) {
             error_count++;
+            telemetry_count(TELEMETRY_SPLIT_ERRORS);
 
             if (error_count > ERROR_DISCONNECT_COUNT) {
                 // reset other half if disconnected
@@ -0,0 +1,177 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "telemetry.h"
+#include "raw_hid.h"
+#include "timer.h"
+#include "action_layer.h"
+#include "host.h"
+#ifdef EEPROM_PROFILE_ENABLE
+#    include "eeprom_profile.h"
+#endif
+
+#ifndef TELEMETRY_INTERVAL
+#    define TELEMETRY_INTERVAL 1000
+#endif
+
+// Stop streaming if the host hasn't renewed the request for this long, so nothing is sent once the viewer is gone
+#ifndef TELEMETRY_TIMEOUT
+#    define TELEMETRY_TIMEOUT 5000
+#endif
+
+// Same size as VIA packets, which every raw HID implementation accepts
+#define TELEMETRY_PACKET_SIZE 32
+#define TELEMETRY_RECORDS_PER_PACKET ((TELEMETRY_PACKET_SIZE - 2) / TELEMETRY_RECORD_SIZE)
+
+static bool     telemetry_active   = false;
+static uint32_t telemetry_request  = 0;
+static uint16_t telemetry_interval = TELEMETRY_INTERVAL;
+static uint32_t telemetry_timer    = 0;
+
+static uint8_t telemetry_packet[TELEMETRY_PACKET_SIZE];
+static uint8_t telemetry_records  = 0;
+static uint8_t telemetry_sequence = 0;
+
+static uint32_t      telemetry_counters[TELEMETRY_COUNTER_COUNT];
+static uint32_t      telemetry_scans = 0;
+static uint32_t      telemetry_loops[TELEMETRY_LOOP_BUCKETS];
+static uint32_t      telemetry_last_loop = 0;
+static layer_state_t telemetry_layer_state;
+static layer_state_t telemetry_default_layer_state;
+
+static void telemetry_flush(void) {
+    if (telemetry_records == 0) {
+        return;
+    }
+    telemetry_packet[0] = TELEMETRY_PACKET_ID;
+    telemetry_packet[1] = telemetry_sequence++;
+    raw_hid_send(telemetry_packet, TELEMETRY_PACKET_SIZE);
+    memset(telemetry_packet, 0, TELEMETRY_PACKET_SIZE);
+    telemetry_records = 0;
+}
+
+static void telemetry_record(uint8_t tag, uint8_t index, uint32_t value) {
+    uint8_t *record = &telemetry_packet[2 + telemetry_records * TELEMETRY_RECORD_SIZE];
+    record[0]       = tag;
+    record[1]       = index;
+    record[2]       = value & 0xFF;
+    record[3]       = (value >> 8) & 0xFF;
+    record[4]       = (value >> 16) & 0xFF;
+    record[5]       = value >> 24;
+    if (++telemetry_records == TELEMETRY_RECORDS_PER_PACKET) {
+        telemetry_flush();
+    }
+}
+
+// Everything that accumulates over an interval, counts are reset afterwards and totals keep running
+static void telemetry_send_interval(uint32_t now) {
+    uint32_t elapsed = TIMER_DIFF_32(now, telemetry_timer);
+
+    telemetry_record(telemetry_uptime, 0, now);
+    telemetry_record(telemetry_scan_rate, 0, elapsed ? telemetry_scans * 1000 / elapsed : 0);
+    for (uint8_t i = 0; i < TELEMETRY_LOOP_BUCKETS; i++) {
+        telemetry_record(telemetry_loop_time, i, telemetry_loops[i]);
+    }
+#ifdef HOST_REPORT_STATS
+    host_report_stats_t stats;
+    host_get_report_stats(&stats);
+    uint32_t *fields = (uint32_t *)&stats;
+    for (uint8_t i = 0; i < sizeof(stats) / sizeof(uint32_t); i++) {
+        telemetry_record(telemetry_reports, i, fields[i]);
+    }
+#endif
+    telemetry_record(telemetry_split_errors, 0, telemetry_counters[TELEMETRY_SPLIT_ERRORS]);
+    telemetry_record(telemetry_eeprom_writes, 0, telemetry_counters[TELEMETRY_EEPROM_WRITES]);
+#ifdef EEPROM_PROFILE_ENABLE
+    for (uint8_t i = 0; i < EEPROM_PROFILE_REGION_COUNT; i++) {
+        telemetry_record(telemetry_eeprom_writes, i + 1, eeprom_profile_get(i)->writes);
+    }
+#endif
+    telemetry_record(telemetry_interval_end, 0, 0);
+    telemetry_flush();
+
+    telemetry_scans = 0;
+    memset(telemetry_loops, 0, sizeof(telemetry_loops));
+    telemetry_timer = now;
+}
+
+void telemetry_count(telemetry_counter_t counter) { telemetry_counters[counter]++; }
+
+/**
+ * Called every matrix scan. Counts the scan and its duration, and streams records while a host is listening.
+ */
+void telemetry_task(void) {
+    uint32_t now  = timer_read32();
+    uint32_t loop = TIMER_DIFF_32(now, telemetry_last_loop);
+    uint8_t  bucket;
+    for (bucket = 0; loop && bucket < TELEMETRY_LOOP_BUCKETS - 1; bucket++) {
+        loop >>= 1;
+    }
+    telemetry_loops[bucket]++;
+    telemetry_scans++;
+    telemetry_last_loop = now;
+
+    if (!telemetry_active) {
+        return;
+    }
+    if (TIMER_DIFF_32(now, telemetry_request) > TELEMETRY_TIMEOUT) {
+        telemetry_active = false;
+        return;
+    }
+
+    if (layer_state != telemetry_layer_state || default_layer_state != telemetry_default_layer_state) {
+        telemetry_layer_state         = layer_state;
+        telemetry_default_layer_state = default_layer_state;
+        telemetry_record(telemetry_layer, 0, layer_state);
+        telemetry_record(telemetry_layer, 1, default_layer_state);
+        telemetry_flush();
+    }
+
+    if (TIMER_DIFF_32(now, telemetry_timer) >= telemetry_interval) {
+        telemetry_send_interval(now);
+    }
+}
+
+bool telemetry_raw_hid_receive(uint8_t *data, uint8_t length) {
+    if (length < 2 || data[0] != TELEMETRY_PACKET_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case telemetry_cmd_start: {
+            uint16_t interval  = length >= 4 ? data[2] | (data[3] << 8) : 0;
+            telemetry_interval = interval ? interval : TELEMETRY_INTERVAL;
+            telemetry_request  = timer_read32();
+            if (!telemetry_active) {
+                // Start from a clean interval, and send the current layers straight away
+                telemetry_active      = true;
+                telemetry_timer       = telemetry_request;
+                telemetry_scans       = 0;
+                telemetry_layer_state = ~layer_state;
+                memset(telemetry_loops, 0, sizeof(telemetry_loops));
+                telemetry_record(telemetry_hello, TELEMETRY_VERSION, telemetry_interval);
+                telemetry_flush();
+            }
+            break;
+        }
+        case telemetry_cmd_stop:
+            telemetry_active = false;
+            break;
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Telemetry packets are RAW_EPSIZE bytes:
+ *
+ *   [0]    TELEMETRY_PACKET_ID
+ *   [1]    sequence number, incremented for every packet so the host can spot drops
+ *   [2..]  records of TELEMETRY_RECORD_SIZE bytes, a record with tag 0 ends the packet
+ *
+ * Each record is a tag, an index and a little endian 32 bit value.
+ *
+ * The host starts the stream by sending {TELEMETRY_PACKET_ID, telemetry_cmd_start, interval_lo, interval_hi}
+ * and must repeat it at least every TELEMETRY_TIMEOUT ms to keep it running. lib/python/qmk/telemetry.py decodes it.
+ */
+
+#define TELEMETRY_PACKET_ID 0xFE
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_RECORD_SIZE 6
+#define TELEMETRY_LOOP_BUCKETS 8
+
+enum telemetry_command_id {
+    telemetry_cmd_start = 0x01,
+    telemetry_cmd_stop  = 0x02,
+};
+
+enum telemetry_tag {
+    telemetry_none          = 0x00,
+    telemetry_hello         = 0x01,  // index: TELEMETRY_VERSION, value: interval in ms
+    telemetry_uptime        = 0x02,  // value: timer_read32() at the start of the interval
+    telemetry_scan_rate     = 0x03,  // value: matrix scans per second
+    telemetry_loop_time     = 0x04,  // index: bucket, value: loops that took [2^(index-1), 2^index) ms, bucket 0 is under 1 ms
+    telemetry_layer         = 0x05,  // index: 0 layer_state, 1 default_layer_state, sent when they change
+    telemetry_reports       = 0x06,  // index: field of host_report_stats_t, value: running total
+    telemetry_split_errors  = 0x07,  // value: running total of failed split transactions
+    telemetry_eeprom_writes = 0x08,  // index: 0 deferred EEPROM flushes, 1 + region EEPROM_PROFILE_ENABLE writes, value: running total
+    telemetry_interval_end  = 0x09,  // the records of one interval are complete
+};
+
+typedef enum {
+    TELEMETRY_SPLIT_ERRORS,
+    TELEMETRY_EEPROM_WRITES,
+    TELEMETRY_COUNTER_COUNT,
+} telemetry_counter_t;
+
+#ifdef TELEMETRY_ENABLE
+void telemetry_task(void);
+void telemetry_count(telemetry_counter_t counter);
+/* returns true if the packet was a telemetry command, which it then consumed */
+bool telemetry_raw_hid_receive(uint8_t *data, uint8_t length);
+#else
+#    define telemetry_count(counter)
+#endif
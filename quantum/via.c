@@ -46,6 +46,21 @@
 #include "dynamic_keymap.h"
 #include "tmk_core/common/eeprom.h"
 #include "version.h"  // for QMK_BUILDDATE used in EEPROM magic
+#include <string.h>   // for memset
+
+#ifdef EEPROM_PROFILE_ENABLE
+#    include "eeprom_profile.h"
+#endif
+
+#if defined(PROTOCOL_CHIBIOS) && defined(USB_OUTPUT_NONBLOCKING)
+// raw_hid_send() drops packets that don't fit its queue, so long replies
+// are sent as room frees up, from raw_hid_send_ready()
+#    include "usb_main.h"
+#    include "protocol/usb_descriptor.h"
+#    define via_raw_hid_send_space() raw_hid_send_space()
+#else
+#    define via_raw_hid_send_space() 1
+#endif
 
 // Forward declare some helpers.
 #if defined(VIA_QMK_BACKLIGHT_ENABLE)
@@ -119,6 +134,8 @@ void via_init(void) {
         // Save the magic number last, in case saving was interrupted
         via_eeprom_set_valid(true);
     }
+    // Load the keymap mirror, if enabled
+    dynamic_keymap_init();
 }
 
 // This is generalized so the layout options EEPROM usage can be
@@ -184,6 +201,92 @@ bool process_record_via(uint16_t keycode, keyrecord_t *record) {
     return true;
 }
 
+// Size in bytes of a bulk transfer region, or 0 if there is no such region
+static uint16_t via_bulk_region_size(uint8_t region) {
+    switch (region) {
+        case id_bulk_region_keymap:
+            return dynamic_keymap_get_layer_count() * MATRIX_ROWS * MATRIX_COLS * 2;
+        case id_bulk_region_macro:
+            return dynamic_keymap_macro_get_buffer_size();
+        default:
+            return 0;
+    }
+}
+
+static void via_bulk_get_buffer(uint8_t region, uint16_t offset, uint16_t size, uint8_t *data) {
+    if (region == id_bulk_region_keymap) {
+        dynamic_keymap_get_buffer(offset, size, data);
+    } else {
+        dynamic_keymap_macro_get_buffer(offset, size, data);
+    }
+}
+
+// Returns false if the keymap could not hold the data
+static bool via_bulk_set_buffer(uint8_t region, uint16_t offset, uint16_t size, uint8_t *data) {
+    if (region == id_bulk_region_keymap) {
+        return dynamic_keymap_set_buffer(offset, size, data);
+    }
+    dynamic_keymap_macro_set_buffer(offset, size, data);
+    return true;
+}
+
+// CRC-16/CCITT over a whole region, so hosts can skip reading unchanged data
+static uint16_t via_bulk_region_checksum(uint8_t region) {
+    uint8_t  chunk[32];
+    uint16_t crc  = 0xFFFF;
+    uint16_t size = via_bulk_region_size(region);
+    for (uint16_t offset = 0; offset < size; offset += sizeof(chunk)) {
+        uint16_t length = size - offset < sizeof(chunk) ? size - offset : sizeof(chunk);
+        via_bulk_get_buffer(region, offset, length, chunk);
+        for (uint16_t i = 0; i < length; i++) {
+            crc ^= (uint16_t)chunk[i] << 8;
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+            }
+        }
+    }
+    return crc;
+}
+
+// State of the bulk write in progress, if remaining is non-zero
+static struct {
+    uint8_t  region;
+    uint8_t  seq;
+    uint16_t offset;
+    uint16_t remaining;
+} via_bulk_write;
+
+// State of the bulk read in progress, if remaining is non-zero
+static struct {
+    uint8_t  region;
+    uint8_t  seq;
+    uint16_t offset;
+    uint16_t remaining;
+} via_bulk_read;
+
+// Sends as many packets of the bulk read in progress as raw_hid_send() can take
+static void via_bulk_read_send(uint8_t *data, uint8_t length) {
+    data[0] = id_dynamic_keymap_bulk_get_buffer;
+    while (via_bulk_read.remaining > 0 && via_raw_hid_send_space() > 0) {
+        uint16_t payload = via_bulk_read.remaining < length - 2 ? via_bulk_read.remaining : length - 2;
+        data[1]          = via_bulk_read.seq++;
+        via_bulk_get_buffer(via_bulk_read.region, via_bulk_read.offset, payload, &data[2]);
+        memset(&data[2 + payload], 0x00, length - 2 - payload);
+        raw_hid_send(data, length);
+        via_bulk_read.offset += payload;
+        via_bulk_read.remaining -= payload;
+    }
+}
+
+#if defined(PROTOCOL_CHIBIOS) && defined(USB_OUTPUT_NONBLOCKING)
+void raw_hid_send_ready(void) {
+    if (via_bulk_read.remaining > 0) {
+        uint8_t data[RAW_EPSIZE];
+        via_bulk_read_send(data, sizeof(data));
+    }
+}
+#endif
+
 // Keyboard level code can override this to handle custom messages from VIA.
 // See raw_hid_receive() implementation.
 // DO NOT call raw_hid_send() in the override function.
@@ -200,8 +303,16 @@ __attribute__((weak)) void raw_hid_receive_kb(uint8_t *data, uint8_t length) {
 // raw_hid_send() is called at the end, with the same buffer, which was
 // possibly modified with returned values.
 void raw_hid_receive(uint8_t *data, uint8_t length) {
+#ifdef TELEMETRY_ENABLE
+    // Telemetry commands get no reply, the stream itself answers them
+    if (telemetry_raw_hid_receive(data, length)) {
+        return;
+    }
+#endif
     uint8_t *command_id   = &(data[0]);
     uint8_t *command_data = &(data[1]);
+    // A new command abandons a bulk read still being sent, so the replies don't interleave
+    via_bulk_read.remaining = 0;
     switch (*command_id) {
         case id_get_protocol_version: {
             command_data[0] = VIA_PROTOCOL_VERSION >> 8;
@@ -245,6 +356,25 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
 #endif
                     break;
                 }
+#ifdef EEPROM_PROFILE_ENABLE
+                case id_eeprom_profile: {
+                    // [value id, region] -> [value id, region, counters as big endian uint32s]
+                    const eeprom_profile_t *profile = eeprom_profile_get(command_data[1]);
+                    if (profile == NULL) {
+                        *command_id = id_unhandled;
+                        break;
+                    }
+                    const uint32_t *counters = (const uint32_t *)profile;
+                    uint8_t         i        = 2;
+                    for (uint8_t j = 0; j < sizeof(eeprom_profile_t) / sizeof(uint32_t); j++) {
+                        command_data[i++] = (counters[j] >> 24) & 0xFF;
+                        command_data[i++] = (counters[j] >> 16) & 0xFF;
+                        command_data[i++] = (counters[j] >> 8) & 0xFF;
+                        command_data[i++] = counters[j] & 0xFF;
+                    }
+                    break;
+                }
+#endif
                 default: {
                     raw_hid_receive_kb(data, length);
                     break;
@@ -259,6 +389,13 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
                     via_set_layout_options(value);
                     break;
                 }
+#ifdef EEPROM_PROFILE_ENABLE
+                case id_eeprom_profile: {
+                    // Clears the counters, apart from the lifetime write counts
+                    eeprom_profile_reset();
+                    break;
+                }
+#endif
                 default: {
                     raw_hid_receive_kb(data, length);
                     break;
@@ -273,7 +410,10 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
             break;
         }
         case id_dynamic_keymap_set_keycode: {
-            dynamic_keymap_set_keycode(command_data[0], command_data[1], command_data[2], (command_data[3] << 8) | command_data[4]);
+            if (!dynamic_keymap_set_keycode(command_data[0], command_data[1], command_data[2], (command_data[3] << 8) | command_data[4])) {
+                // The keymap is full, the key was left unchanged
+                *command_id = id_unhandled;
+            }
             break;
         }
         case id_dynamic_keymap_reset: {
@@ -367,7 +507,91 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
         case id_dynamic_keymap_set_buffer: {
             uint16_t offset = (command_data[0] << 8) | command_data[1];
             uint16_t size   = command_data[2];  // size <= 28
-            dynamic_keymap_set_buffer(offset, size, &command_data[3]);
+            if (!dynamic_keymap_set_buffer(offset, size, &command_data[3])) {
+                *command_id = id_unhandled;
+            }
+            break;
+        }
+        case id_dynamic_keymap_get_checksum: {
+            uint8_t  region = command_data[0];
+            uint16_t size   = via_bulk_region_size(region);
+            if (size == 0) {
+                *command_id = id_unhandled;
+                break;
+            }
+            uint16_t crc    = via_bulk_region_checksum(region);
+            command_data[1] = size >> 8;
+            command_data[2] = size & 0xFF;
+            command_data[3] = crc >> 8;
+            command_data[4] = crc & 0xFF;
+            break;
+        }
+        case id_dynamic_keymap_bulk_get_buffer: {
+            uint8_t  region = command_data[0];
+            uint16_t offset = (command_data[1] << 8) | command_data[2];
+            uint16_t size   = (command_data[3] << 8) | command_data[4];
+            uint16_t end    = via_bulk_region_size(region);
+            if (offset >= end) {
+                *command_id = id_unhandled;
+                break;
+            }
+            if (size > end - offset) {
+                size = end - offset;
+            }
+            // Stream the data back, the host reads the packets without asking for each one
+            via_bulk_read.region    = region;
+            via_bulk_read.seq       = 0;
+            via_bulk_read.offset    = offset;
+            via_bulk_read.remaining = size;
+            via_bulk_read_send(data, length);
+            return;
+        }
+        case id_dynamic_keymap_bulk_set_buffer: {
+            uint8_t  region = command_data[0];
+            uint16_t offset = (command_data[1] << 8) | command_data[2];
+            uint16_t size   = (command_data[3] << 8) | command_data[4];
+            // Reject writes past the end of the region, rather than clamp them and report success
+            via_bulk_write.remaining = 0;
+            if (offset >= via_bulk_region_size(region) || size > via_bulk_region_size(region) - offset) {
+                *command_id = id_unhandled;
+                break;
+            }
+            via_bulk_write.region    = region;
+            via_bulk_write.seq       = 0;
+            via_bulk_write.offset    = offset;
+            via_bulk_write.remaining = size;
+            if (region == id_bulk_region_keymap) {
+                dynamic_keymap_set_buffer_begin(via_bulk_write.offset, via_bulk_write.remaining);
+            }
+            break;
+        }
+        case id_dynamic_keymap_bulk_data: {
+            if (via_bulk_write.remaining == 0) {
+                *command_id = id_unhandled;
+                break;
+            }
+            if (command_data[0] != via_bulk_write.seq) {
+                // Abandon the transfer, the host has to start it again
+                via_bulk_write.remaining = 0;
+                command_data[0]          = via_bulk_write.seq;
+                command_data[1]          = id_bulk_status_sequence_error;
+                break;
+            }
+            uint16_t payload = via_bulk_write.remaining < length - 2 ? via_bulk_write.remaining : length - 2;
+            if (!via_bulk_set_buffer(via_bulk_write.region, via_bulk_write.offset, payload, &command_data[1])) {
+                via_bulk_write.remaining = 0;
+                command_data[0]          = via_bulk_write.seq;
+                command_data[1]          = id_bulk_status_keymap_full;
+                break;
+            }
+            via_bulk_write.seq++;
+            via_bulk_write.offset += payload;
+            via_bulk_write.remaining -= payload;
+            if (via_bulk_write.remaining > 0) {
+                // Only the last packet of the transfer is answered
+                return;
+            }
+            command_data[1] = id_bulk_status_ok;
             break;
         }
         case id_eeprom_reset: {
@@ -378,6 +602,10 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
             // Need to send data back before the jump
             // Informs host that the command is handled
             raw_hid_send(data, length);
+            // Don't lose keycodes still waiting to be written back
+            dynamic_keymap_flush();
+            // Nor deferred lighting settings
+            eeconfig_flush();
             // Give host time to read it
             wait_ms(100);
             bootloader_jump();
@@ -78,13 +78,43 @@ enum via_command_id {
     id_dynamic_keymap_get_layer_count       = 0x11,
     id_dynamic_keymap_get_buffer            = 0x12,
     id_dynamic_keymap_set_buffer            = 0x13,
+    id_dynamic_keymap_get_checksum          = 0x14,
+    id_dynamic_keymap_bulk_get_buffer       = 0x15,
+    id_dynamic_keymap_bulk_set_buffer       = 0x16,
+    id_dynamic_keymap_bulk_data             = 0x17,
     id_unhandled                            = 0xFF,
 };
 
+// Bulk transfers move a whole region without a round trip per packet.
+// Firmware without them answers id_unhandled, so hosts can fall back
+// to id_dynamic_keymap_get_buffer/set_buffer.
+//
+// id_dynamic_keymap_get_checksum: [id, region] -> [id, region, size (2), CRC-16/CCITT (2)]
+// id_dynamic_keymap_bulk_get_buffer: [id, region, offset (2), size (2)] -> a stream of
+//     [id, seq, data (up to 30)] packets, seq counting up from 0. The size is clamped
+//     to the end of the region, an offset past the end is answered id_unhandled.
+// id_dynamic_keymap_bulk_set_buffer: [id, region, offset (2), size (2)] -> echoed, or
+//     id_unhandled if the range doesn't fit in the region. Then the
+//     host sends [id_dynamic_keymap_bulk_data, seq, data (up to 30)] packets, seq counting
+//     up from 0. Only the last packet, or one out of sequence or that did not fit in the
+//     keymap, is answered with [id_dynamic_keymap_bulk_data, seq, status].
+// Multi-byte values are big endian.
+enum via_bulk_region {
+    id_bulk_region_keymap = 0x00,
+    id_bulk_region_macro  = 0x01,
+};
+
+enum via_bulk_status {
+    id_bulk_status_ok             = 0x00,
+    id_bulk_status_sequence_error = 0x01,
+    id_bulk_status_keymap_full    = 0x02,
+};
+
 enum via_keyboard_value_id {
     id_uptime              = 0x01,  //
     id_layout_options      = 0x02,
-    id_switch_matrix_state = 0x03
+    id_switch_matrix_state = 0x03,
+    id_eeprom_profile      = 0x04,  // needs EEPROM_PROFILE_ENABLE
 };
 
 enum via_lighting_value {
@@ -0,0 +1,112 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "keycode_config.h"
+}
+
+using testing::_;
+
+class HostReport : public TestFixture {
+   protected:
+    void SetUp() override {
+        keymap_config.nkro = false;
+        keyboard_protocol  = 1;
+        host_clear_report_stats();
+    }
+
+    static report_keyboard_t report_with(uint8_t keycode) {
+        report_keyboard_t report = {};
+        report.keys[0]           = keycode;
+        return report;
+    }
+};
+
+TEST_F(HostReport, RepeatedKeyboardReportIsSkipped) {
+    TestDriver        driver;
+    report_keyboard_t report = report_with(KC_A);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(1);
+    host_keyboard_send(&report);
+    host_keyboard_send(&report);
+
+    host_report_stats_t stats;
+    host_get_report_stats(&stats);
+    EXPECT_EQ(stats.keyboard_sent, 1);
+    EXPECT_EQ(stats.keyboard_suppressed, 1);
+}
+
+TEST_F(HostReport, KeyboardReportIsResentAfterNkroSwitch) {
+    TestDriver        driver;
+    report_keyboard_t report = report_with(KC_B);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(2);
+    host_keyboard_send(&report);
+    keymap_config.nkro = true;
+    report             = report_with(KC_B);
+    host_keyboard_send(&report);
+    keymap_config.nkro = false;
+}
+
+TEST_F(HostReport, KeyboardReportIsResentAfterProtocolSwitch) {
+    TestDriver        driver;
+    report_keyboard_t report = report_with(KC_C);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(2);
+    host_keyboard_send(&report);
+    keyboard_protocol = 0;
+    host_keyboard_send(&report);
+    keyboard_protocol = 1;
+}
+
+TEST_F(HostReport, KeyboardReportIsResentAfterItWasLost) {
+    TestDriver        driver;
+    report_keyboard_t report = report_with(KC_D);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(2);
+    host_keyboard_send(&report);
+    host_keyboard_report_lost();
+    host_keyboard_send(&report);
+
+    host_report_stats_t stats;
+    host_get_report_stats(&stats);
+    EXPECT_EQ(stats.keyboard_sent, 2);
+    EXPECT_EQ(stats.keyboard_suppressed, 0);
+}
+
+TEST_F(HostReport, KeyboardReportIsResentAfterDriverSwitch) {
+    TestDriver        driver;
+    report_keyboard_t report = report_with(KC_E);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(2);
+    host_keyboard_send(&report);
+    host_set_driver(host_get_driver());
+    host_keyboard_send(&report);
+}
+
+TEST_F(HostReport, RepeatedSystemAndConsumerReportsAreSkipped) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_system_mock(SYSTEM_SLEEP)).Times(1);
+    EXPECT_CALL(driver, send_consumer_mock(AUDIO_MUTE)).Times(1);
+    host_system_send(SYSTEM_SLEEP);
+    host_system_send(SYSTEM_SLEEP);
+    host_consumer_send(AUDIO_MUTE);
+    host_consumer_send(AUDIO_MUTE);
+
+    host_report_stats_t stats;
+    host_get_report_stats(&stats);
+    EXPECT_EQ(stats.system_sent, 1);
+    EXPECT_EQ(stats.system_suppressed, 1);
+    EXPECT_EQ(stats.consumer_sent, 1);
+    EXPECT_EQ(stats.consumer_suppressed, 1);
+}
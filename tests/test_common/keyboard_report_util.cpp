@@ -17,16 +17,28 @@
 #include "keyboard_report_util.hpp"
 #include <vector>
 #include <algorithm>
+#ifdef NKRO_ENABLE
+extern "C" {
+#    include "keycode_config.h"
+}
+#endif
 using namespace testing;
 
 namespace {
 std::vector<uint8_t> get_keys(const report_keyboard_t& report) {
     std::vector<uint8_t> result;
-#if defined(NKRO_ENABLE)
-#    error NKRO support not implemented yet
-#elif defined(USB_6KRO_ENABLE)
+#if defined(USB_6KRO_ENABLE)
 #    error 6KRO support not implemented yet
 #else
+#    if defined(NKRO_ENABLE)
+    if (keymap_config.nkro) {
+        for (size_t i = 0; i < KEYBOARD_REPORT_BITS * 8; i++) {
+            if (report.nkro.bits[i / 8] & (1 << (i % 8))) {
+                result.emplace_back(i);
+            }
+        }
+    } else
+#    endif
     for (size_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
         if (report.keys[i]) {
             result.emplace_back(report.keys[i]);
@@ -18,6 +18,9 @@
 
 TestDriver* TestDriver::m_this = nullptr;
 
+// Owned by the USB driver on real hardware
+uint8_t keyboard_protocol = 1;
+
 TestDriver::TestDriver() : m_driver{&TestDriver::keyboard_leds, &TestDriver::send_keyboard, &TestDriver::send_mouse, &TestDriver::send_system, &TestDriver::send_consumer} {
     host_set_driver(&m_driver);
     m_this = this;
@@ -33,4 +36,4 @@ void TestDriver::send_mouse(report_mouse_t* report) { m_this->send_mouse_mock(*r
 
 void TestDriver::send_system(uint16_t data) { m_this->send_system_mock(data); }
 
-void TestDriver::send_consumer(uint16_t data) { m_this->send_consumer(data); }
+void TestDriver::send_consumer(uint16_t data) { m_this->send_consumer_mock(data); }
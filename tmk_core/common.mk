@@ -121,6 +121,15 @@ ifeq ($(strip $(SLEEP_LED_ENABLE)), yes)
     TMK_COMMON_DEFS += -DNO_SUSPEND_POWER_DOWN
 endif
 
+ifeq ($(strip $(EEPROM_PROFILE_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/eeprom_profile.c
+    TMK_COMMON_DEFS += -DEEPROM_PROFILE_ENABLE
+    EEPROM_PROFILE_FUNCTIONS := read_byte read_word read_dword read_block \
+                                write_byte write_word write_dword write_block \
+                                update_byte update_word update_dword update_block
+    TMK_COMMON_LDFLAGS += $(foreach f,$(EEPROM_PROFILE_FUNCTIONS),-Wl,--wrap=eeprom_$(f))
+endif
+
 ifeq ($(strip $(NO_SUSPEND_POWER_DOWN)), yes)
     TMK_COMMON_DEFS += -DNO_SUSPEND_POWER_DOWN
 endif
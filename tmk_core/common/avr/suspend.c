@@ -9,6 +9,7 @@
 #include "timer.h"
 #include "led.h"
 #include "host.h"
+#include "eeconfig.h"
 
 #ifdef PROTOCOL_LUFA
 #    include "lufa.h"
@@ -135,6 +136,9 @@ static void power_down(uint8_t wdto) {
  * FIXME: needs doc
  */
 void suspend_power_down(void) {
+    // Write back deferred config before the host may cut power
+    eeconfig_flush();
+
     suspend_power_down_kb();
 
 #ifndef NO_SUSPEND_POWER_DOWN
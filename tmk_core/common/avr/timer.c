@@ -21,6 +21,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdint.h>
 #include "timer_avr.h"
 #include "timer.h"
+#if defined(ENCODER_ENABLE) && defined(ENCODER_TIMER_SAMPLING)
+#    include "encoder.h"
+#endif
 
 // counter resolution 1ms
 // NOTE: union { uint32_t timer32; struct { uint16_t dummy; uint16_t timer16; }}
@@ -130,4 +133,9 @@ inline uint32_t timer_elapsed32(uint32_t last) {
 #else
 #    define TIMER_INTERRUPT_VECTOR TIMER0_COMP_vect
 #endif
-ISR(TIMER_INTERRUPT_VECTOR, ISR_NOBLOCK) { timer_count++; }
+ISR(TIMER_INTERRUPT_VECTOR, ISR_NOBLOCK) {
+    timer_count++;
+#if defined(ENCODER_ENABLE) && defined(ENCODER_TIMER_SAMPLING)
+    encoder_sample();
+#endif
+}
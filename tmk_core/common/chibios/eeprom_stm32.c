@@ -17,6 +17,7 @@
  */
 
 #include <stdio.h>
+#include <stdbool.h>
 #include <string.h>
 #include "eeprom_stm32.h"
 /*****************************************************************************
@@ -27,21 +28,134 @@
  ******************************************************************************/
 
 /* Private macro -------------------------------------------------------------*/
+#define FEE_READ_HALF_WORD(Address) (*(__IO uint16_t *)(Address))
+
 /* Private variables ---------------------------------------------------------*/
+// RAM copy of the emulated EEPROM, rebuilt from flash by EEPROM_Init
+static uint8_t DataBuf[FEE_DENSITY_BYTES + 1];
+// Bank holding the current compacted copy and write log, and its sequence number
+static uint8_t  ActiveBank     = 0;
+static uint16_t ActiveSequence = 0;
+// Next free record in the write log
+static uint32_t WriteLogAddress = FEE_WRITE_LOG_BASE_ADDRESS(0);
+// Set when the firmware has grown into the reserved pages, the data is then only kept in RAM
+static bool FlashOverlap = false;
+
+// Where the firmware image ends in flash: the initialised data is stored after the code
+extern uint8_t __textdata_base__[], __data_base__[], __data_end__[];
+
 /* Functions -----------------------------------------------------------------*/
 
-uint8_t DataBuf[FEE_PAGE_SIZE];
+static bool EEPROM_BankValid(uint8_t Bank) { return FEE_READ_HALF_WORD(FEE_BANK_HEADER_ADDRESS(Bank)) == FEE_BANK_MAGIC; }
+
+static uint16_t EEPROM_BankSequence(uint8_t Bank) { return FEE_READ_HALF_WORD(FEE_BANK_HEADER_ADDRESS(Bank) + 2); }
+
+static FLASH_Status EEPROM_EraseBank(uint8_t Bank) {
+    FLASH_Status FlashStatus = FLASH_COMPLETE;
+    uint32_t     page;
+
+    for (page = FEE_BANK_BASE_ADDRESS(Bank); page < FEE_BANK_BASE_ADDRESS(Bank) + FEE_BANK_SIZE && FlashStatus == FLASH_COMPLETE; page += FEE_PAGE_SIZE) {
+        FlashStatus = FLASH_ErasePage(page);
+    }
+
+    return FlashStatus;
+}
+
+/*****************************************************************************
+ *  Mark a bank as valid. The magic is programmed after the sequence number,
+ *  so a header torn by a power loss never reads back as valid.
+ ******************************************************************************/
+static FLASH_Status EEPROM_CommitBank(uint8_t Bank, uint16_t Sequence) {
+    FLASH_Status FlashStatus = FLASH_ProgramHalfWord(FEE_BANK_HEADER_ADDRESS(Bank) + 2, Sequence);
+
+    if (FlashStatus == FLASH_COMPLETE) {
+        FlashStatus = FLASH_ProgramHalfWord(FEE_BANK_HEADER_ADDRESS(Bank), FEE_BANK_MAGIC);
+    }
+    if (FlashStatus == FLASH_COMPLETE) {
+        ActiveBank      = Bank;
+        ActiveSequence  = Sequence;
+        WriteLogAddress = FEE_WRITE_LOG_BASE_ADDRESS(Bank);
+    }
+
+    return FlashStatus;
+}
+
 /*****************************************************************************
- *  Delete Flash Space used for user Data, deletes the whole space between
- *  RW_PAGE_BASE_ADDRESS and the last uC Flash Page
+ *  Program the current contents of the RAM copy into the spare bank and commit
+ *  it, then erase the old bank. The old bank stays valid until the new one is
+ *  committed, so a power loss at any point keeps one complete copy. Only runs
+ *  once the log is full.
+ ******************************************************************************/
+static FLASH_Status EEPROM_Compact(void) {
+    uint8_t      OldBank     = ActiveBank;
+    uint8_t      Bank        = ActiveBank ^ 1;
+    FLASH_Status FlashStatus = EEPROM_EraseBank(Bank);
+    uint16_t     i;
+
+    // erased flash already reads back as 0xFF, only program the words that differ
+    for (i = 0; i <= FEE_DENSITY_BYTES && FlashStatus == FLASH_COMPLETE; i += 2) {
+        uint16_t value = DataBuf[i] | (DataBuf[i + 1] << 8);
+        if (value != FEE_EMPTY_WORD) {
+            FlashStatus = FLASH_ProgramHalfWord(FEE_BANK_BASE_ADDRESS(Bank) + i, value);
+        }
+    }
+
+    if (FlashStatus == FLASH_COMPLETE) {
+        FlashStatus = EEPROM_CommitBank(Bank, ActiveSequence + 1);
+    }
+    if (FlashStatus == FLASH_COMPLETE) {
+        FlashStatus = EEPROM_EraseBank(OldBank);
+    }
+
+    return FlashStatus;
+}
+
+/*****************************************************************************
+ *  Unlock the flash and rebuild the RAM copy from the newest valid bank: its
+ *  compacted area, then its write log. Records are replayed in order, so the
+ *  newest value wins.
  ******************************************************************************/
 uint16_t EEPROM_Init(void) {
+    // never erase or program pages holding the firmware itself
+    if ((uint32_t)__textdata_base__ + (uint32_t)(__data_end__ - __data_base__) > FEE_PAGE_BASE_ADDRESS) {
+        FlashOverlap = true;
+        memset(DataBuf, 0xFF, sizeof(DataBuf));
+        return FEE_DENSITY_BYTES;
+    }
+
     // unlock flash
     FLASH_Unlock();
 
     // Clear Flags
     // FLASH_ClearFlag(FLASH_SR_EOP|FLASH_SR_PGERR|FLASH_SR_WRPERR);
 
+    bool valid0 = EEPROM_BankValid(0);
+    bool valid1 = EEPROM_BankValid(1);
+
+    if (!valid0 && !valid1) {
+        // blank flash, or data from an older layout
+        EEPROM_Erase();
+        return FEE_DENSITY_BYTES;
+    }
+
+    // both banks are only valid after a power loss while erasing the old one
+    ActiveBank     = (valid1 && (!valid0 || (int16_t)(EEPROM_BankSequence(1) - EEPROM_BankSequence(0)) > 0)) ? 1 : 0;
+    ActiveSequence = EEPROM_BankSequence(ActiveBank);
+
+    memcpy(DataBuf, (uint8_t *)FEE_BANK_BASE_ADDRESS(ActiveBank), sizeof(DataBuf));
+
+    for (WriteLogAddress = FEE_WRITE_LOG_BASE_ADDRESS(ActiveBank); WriteLogAddress < FEE_WRITE_LOG_END_ADDRESS(ActiveBank); WriteLogAddress += FEE_WRITE_LOG_RECORD_SIZE) {
+        uint16_t Address = FEE_READ_HALF_WORD(WriteLogAddress);
+        uint16_t Value   = FEE_READ_HALF_WORD(WriteLogAddress + 2);
+        if (Address == FEE_EMPTY_WORD) {
+            break;
+        }
+        // skip records interrupted by a power loss before the value was programmed
+        if (Address <= FEE_DENSITY_BYTES && Value <= 0xFF) {
+            DataBuf[Address] = (uint8_t)Value;
+        }
+    }
+
     return FEE_DENSITY_BYTES;
 }
 /*****************************************************************************
@@ -50,56 +164,53 @@ uint16_t EEPROM_Init(void) {
 void EEPROM_Erase(void) {
     int page_num = 0;
 
+    if (FlashOverlap) {
+        memset(DataBuf, 0xFF, sizeof(DataBuf));
+        return;
+    }
+
     // delete all pages from specified start page to the last page
     do {
         FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + (page_num * FEE_PAGE_SIZE));
         page_num++;
-    } while (page_num < FEE_DENSITY_PAGES);
+    } while (page_num < 2 * FEE_DENSITY_PAGES);
+
+    memset(DataBuf, 0xFF, sizeof(DataBuf));
+    EEPROM_CommitBank(0, 0);
 }
 /*****************************************************************************
- *  Writes once data byte to flash on specified address. If a byte is already
- *  written, the whole page must be copied to a buffer, the byte changed and
- *  the manipulated buffer written after PageErase.
+ *  Writes once data byte to flash on specified address. The change is appended
+ *  to the write log, only when the log is full are the pages erased and the
+ *  data compacted.
  *******************************************************************************/
 uint16_t EEPROM_WriteDataByte(uint16_t Address, uint8_t DataByte) {
     FLASH_Status FlashStatus = FLASH_COMPLETE;
 
-    uint32_t page;
-    int      i;
-
     // exit if desired address is above the limit (e.G. under 2048 Bytes for 4 pages)
     if (Address > FEE_DENSITY_BYTES) {
         return 0;
     }
 
-    // calculate which page is affected (Pagenum1/Pagenum2...PagenumN)
-    page = FEE_ADDR_OFFSET(Address) / FEE_PAGE_SIZE;
-
-    // if current data is 0xFF, the byte is empty, just overwrite with the new one
-    if ((*(__IO uint16_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address))) == FEE_EMPTY_WORD) {
-        FlashStatus = FLASH_ProgramHalfWord(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address), (uint16_t)(0x00FF & DataByte));
-    } else {
-        // Copy Page to a buffer
-        memcpy(DataBuf, (uint8_t *)FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE), FEE_PAGE_SIZE);  // !!! Calculate base address for the desired page
-
-        // check if new data is differ to current data, return if not, proceed if yes
-        if (DataByte == *(__IO uint8_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address))) {
-            return 0;
-        }
+    // check if new data is differ to current data, return if not, proceed if yes
+    if (DataBuf[Address] == DataByte) {
+        return 0;
+    }
+    DataBuf[Address] = DataByte;
 
-        // manipulate desired data byte in temp data array if new byte is differ to the current
-        DataBuf[FEE_ADDR_OFFSET(Address) % FEE_PAGE_SIZE] = DataByte;
+    if (FlashOverlap) {
+        return 0;
+    }
 
-        // Erase Page
-        FlashStatus = FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE));
+    if (WriteLogAddress >= FEE_WRITE_LOG_END_ADDRESS(ActiveBank)) {
+        return EEPROM_Compact();
+    }
 
-        // Write new data (whole page) to flash if data has been changed
-        for (i = 0; i < (FEE_PAGE_SIZE / 2); i++) {
-            if ((__IO uint16_t)(0xFF00 | DataBuf[FEE_ADDR_OFFSET(i)]) != 0xFFFF) {
-                FlashStatus = FLASH_ProgramHalfWord((FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE)) + (i * 2), (uint16_t)(0xFF00 | DataBuf[FEE_ADDR_OFFSET(i)]));
-            }
-        }
+    FlashStatus = FLASH_ProgramHalfWord(WriteLogAddress, Address);
+    if (FlashStatus == FLASH_COMPLETE) {
+        FlashStatus = FLASH_ProgramHalfWord(WriteLogAddress + 2, DataByte);
     }
+    WriteLogAddress += FEE_WRITE_LOG_RECORD_SIZE;
+
     return FlashStatus;
 }
 /*****************************************************************************
@@ -108,8 +219,10 @@ uint16_t EEPROM_WriteDataByte(uint16_t Address, uint8_t DataByte) {
 uint8_t EEPROM_ReadDataByte(uint16_t Address) {
     uint8_t DataByte = 0xFF;
 
-    // Get Byte from specified address
-    DataByte = (*(__IO uint8_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address)));
+    // Get Byte from the RAM copy
+    if (Address <= FEE_DENSITY_BYTES) {
+        DataByte = DataBuf[Address];
+    }
 
     return DataByte;
 }
@@ -17,7 +17,8 @@
  *
  * This library assumes 8-bit data locations. To add a new MCU, please provide the flash
  * page size and the total flash size in Kb. The number of available pages must be a multiple
- * of 2. Only half of the pages account for the total EEPROM size.
+ * of 2. Only half of the pages account for the total EEPROM size, and two banks of
+ * FEE_DENSITY_PAGES pages are reserved so compaction never erases the only valid copy.
  * This library also assumes that the pages are not used by the firmware.
  */
 
@@ -68,11 +69,20 @@
 
 // DONT CHANGE
 // Choose location for the first EEPROM Page address on the top of flash
-#define FEE_PAGE_BASE_ADDRESS ((uint32_t)(0x8000000 + FEE_MCU_FLASH_SIZE * 1024 - FEE_DENSITY_PAGES * FEE_PAGE_SIZE))
+// Two banks of FEE_DENSITY_PAGES pages each. In a bank the first half holds a compacted copy
+// of the data, one byte per byte, the second half starts with the bank header (magic and
+// sequence number) followed by a log of (address, value) records appended on every write.
+#define FEE_BANK_SIZE ((uint32_t)FEE_PAGE_SIZE * FEE_DENSITY_PAGES)
+#define FEE_PAGE_BASE_ADDRESS ((uint32_t)(0x8000000 + FEE_MCU_FLASH_SIZE * 1024 - 2 * FEE_BANK_SIZE))
 #define FEE_DENSITY_BYTES ((FEE_PAGE_SIZE / 2) * FEE_DENSITY_PAGES - 1)
-#define FEE_LAST_PAGE_ADDRESS (FEE_PAGE_BASE_ADDRESS + (FEE_PAGE_SIZE * FEE_DENSITY_PAGES))
+#define FEE_LAST_PAGE_ADDRESS (FEE_PAGE_BASE_ADDRESS + 2 * FEE_BANK_SIZE)
 #define FEE_EMPTY_WORD ((uint16_t)0xFFFF)
-#define FEE_ADDR_OFFSET(Address) (Address * 2)  // 1Byte per Word will be saved to preserve Flash
+#define FEE_BANK_BASE_ADDRESS(Bank) (FEE_PAGE_BASE_ADDRESS + (Bank) * FEE_BANK_SIZE)
+#define FEE_BANK_HEADER_ADDRESS(Bank) (FEE_BANK_BASE_ADDRESS(Bank) + FEE_DENSITY_BYTES + 1)
+#define FEE_BANK_MAGIC ((uint16_t)0xEE51)
+#define FEE_WRITE_LOG_BASE_ADDRESS(Bank) (FEE_BANK_HEADER_ADDRESS(Bank) + FEE_WRITE_LOG_RECORD_SIZE)
+#define FEE_WRITE_LOG_END_ADDRESS(Bank) (FEE_BANK_BASE_ADDRESS(Bank) + FEE_BANK_SIZE)
+#define FEE_WRITE_LOG_RECORD_SIZE 4  // address half-word followed by value half-word
 
 // Use this function to initialize the functionality
 uint16_t EEPROM_Init(void);
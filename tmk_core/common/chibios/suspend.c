@@ -11,6 +11,7 @@
 #include "suspend.h"
 #include "led.h"
 #include "wait.h"
+#include "eeconfig.h"
 
 #ifdef BACKLIGHT_ENABLE
 #    include "backlight.h"
@@ -48,6 +49,9 @@ __attribute__((weak)) void suspend_power_down_kb(void) { suspend_power_down_user
  * FIXME: needs doc
  */
 void suspend_power_down(void) {
+    // Write back deferred config before the host may cut power
+    eeconfig_flush();
+
 #ifdef BACKLIGHT_ENABLE
     backlight_set(0);
 #endif
@@ -35,11 +35,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "quantum.h"
 #include "version.h"
 
+#ifdef EEPROM_PROFILE_ENABLE
+#    include "eeprom_profile.h"
+#endif
+
 #ifdef BACKLIGHT_ENABLE
 #    include "backlight.h"
 #endif
 
-#if defined(MOUSEKEY_ENABLE) && !defined(MK_3_SPEED)
+#if defined(MOUSEKEY_ENABLE) && !defined(MK_3_SPEED) && !defined(MK_KINETIC)
 #    include "mousekey.h"
 #endif
 
@@ -53,7 +57,7 @@ static void print_version(void);
 static void print_status(void);
 static bool command_console(uint8_t code);
 static void command_console_help(void);
-#if defined(MOUSEKEY_ENABLE) && !defined(MK_3_SPEED)
+#if defined(MOUSEKEY_ENABLE) && !defined(MK_3_SPEED) && !defined(MK_KINETIC)
 static bool mousekey_console(uint8_t code);
 static void mousekey_console_help(void);
 #endif
@@ -74,7 +78,7 @@ bool command_proc(uint8_t code) {
             else
                 return (command_console_extra(code) || command_console(code));
             break;
-#if defined(MOUSEKEY_ENABLE) && !defined(MK_3_SPEED)
+#if defined(MOUSEKEY_ENABLE) && !defined(MK_3_SPEED) && !defined(MK_KINETIC)
         case MOUSEKEY:
             mousekey_console(code);
             break;
@@ -310,6 +314,9 @@ static bool command_common(uint8_t code) {
         case MAGIC_KC(MAGIC_KEY_EEPROM):
             print("eeconfig:\n");
             print_eeconfig();
+#ifdef EEPROM_PROFILE_ENABLE
+            eeprom_profile_print();
+#endif
             break;
 
         // clear eeprom
@@ -526,7 +533,7 @@ static bool command_console(uint8_t code) {
         case KC_ESC:
             command_state = ONESHOT;
             return false;
-#if defined(MOUSEKEY_ENABLE) && !defined(MK_3_SPEED)
+#if defined(MOUSEKEY_ENABLE) && !defined(MK_3_SPEED) && !defined(MK_KINETIC)
         case KC_M:
             mousekey_console_help();
             print("M> ");
@@ -541,7 +548,7 @@ static bool command_console(uint8_t code) {
     return true;
 }
 
-#if defined(MOUSEKEY_ENABLE) && !defined(MK_3_SPEED)
+#if defined(MOUSEKEY_ENABLE) && !defined(MK_3_SPEED) && !defined(MK_KINETIC)
 /***********************************************************
  * Mousekey console
  ***********************************************************/
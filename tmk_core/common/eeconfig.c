@@ -3,6 +3,8 @@
 #include "eeprom.h"
 #include "eeconfig.h"
 #include "action_layer.h"
+#include "timer.h"
+#include "telemetry.h"
 
 #ifdef STM32_EEPROM_ENABLE
 #    include "hal.h"
@@ -13,6 +15,104 @@
 #    include "eeprom_driver.h"
 #endif
 
+#ifndef EECONFIG_DEFERRED_WRITE_DELAY
+#    define EECONFIG_DEFERRED_WRITE_DELAY 1000
+#endif
+
+#ifndef EECONFIG_DEFERRED_WRITE_SLOTS
+#    define EECONFIG_DEFERRED_WRITE_SLOTS 4
+#endif
+
+static eeconfig_flush_f eeconfig_dirty[EECONFIG_DEFERRED_WRITE_SLOTS];
+static uint8_t          eeconfig_dirty_count = 0;
+static uint16_t         eeconfig_dirty_timer = 0;
+
+#ifdef EECONFIG_TRANSACTIONAL
+#    include <string.h>
+
+// RAM copy of the config block, the EEPROM is only read when it is loaded
+static uint8_t eeconfig_cache[EECONFIG_BASE_SIZE];
+static bool    eeconfig_loaded      = false;
+static bool    eeconfig_cache_dirty = false;
+static uint8_t eeconfig_txn_depth   = 0;
+
+static uint16_t eeconfig_crc(const uint8_t *data, uint8_t version) {
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i <= EECONFIG_BASE_SIZE; i++) {
+        crc ^= (uint16_t)(i < EECONFIG_BASE_SIZE ? data[i] : version) << 8;
+        for (uint8_t j = 0; j < 8; j++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static bool eeconfig_copy_valid(const uint8_t *data, const uint8_t *footer) { return eeconfig_crc(data, footer[0]) == (footer[1] | (footer[2] << 8)); }
+
+/* Writes the cache to the shadow copy first and to the primary copy second,
+ * so a reset part way through always leaves one copy with a valid CRC.
+ */
+static void eeconfig_store(void) {
+    uint16_t crc                          = eeconfig_crc(eeconfig_cache, EECONFIG_VERSION);
+    uint8_t  footer[EECONFIG_FOOTER_SIZE] = {EECONFIG_VERSION, crc & 0xFF, crc >> 8};
+
+    eeprom_update_block(eeconfig_cache, EECONFIG_SHADOW, EECONFIG_BASE_SIZE);
+    eeprom_update_block(footer, EECONFIG_SHADOW_FOOTER, EECONFIG_FOOTER_SIZE);
+    eeprom_update_block(eeconfig_cache, (void *)0, EECONFIG_BASE_SIZE);
+    eeprom_update_block(footer, EECONFIG_FOOTER, EECONFIG_FOOTER_SIZE);
+    eeconfig_cache_dirty = false;
+}
+
+/* Loads the primary copy, falling back to the shadow copy if the primary
+ * was torn by a reset, and migrates blocks written by an older layout.
+ */
+static void eeconfig_load(void) {
+    uint8_t footer[EECONFIG_FOOTER_SIZE];
+    uint8_t version;
+
+    eeconfig_loaded      = true;
+    eeconfig_cache_dirty = false;
+    eeprom_read_block(eeconfig_cache, (void *)0, EECONFIG_BASE_SIZE);
+    eeprom_read_block(footer, EECONFIG_FOOTER, EECONFIG_FOOTER_SIZE);
+    if (eeconfig_copy_valid(eeconfig_cache, footer)) {
+        version = footer[0];
+    } else {
+        eeprom_read_block(eeconfig_cache, EECONFIG_SHADOW, EECONFIG_BASE_SIZE);
+        eeprom_read_block(footer, EECONFIG_SHADOW_FOOTER, EECONFIG_FOOTER_SIZE);
+        if (eeconfig_copy_valid(eeconfig_cache, footer)) {
+            version              = footer[0];
+            eeconfig_cache_dirty = true;
+        } else {
+            // No valid copy, so this is either blank or a block written before the footer existed
+            eeprom_read_block(eeconfig_cache, (void *)0, EECONFIG_BASE_SIZE);
+            version = 0;
+        }
+    }
+
+    uint16_t magic;
+    memcpy(&magic, eeconfig_cache, sizeof(magic));
+    if (magic == EECONFIG_MAGIC_NUMBER && version < EECONFIG_VERSION) {
+        eeconfig_txn_depth++;
+        eeconfig_migrate_kb(version);
+        eeconfig_txn_depth--;
+        eeconfig_cache_dirty = true;
+    }
+    if (eeconfig_cache_dirty) {
+        eeconfig_store();
+    }
+}
+
+static bool eeconfig_cached(const void *addr, size_t len) {
+    if ((uintptr_t)addr + len > EECONFIG_BASE_SIZE) {
+        return false;
+    }
+    if (!eeconfig_loaded) {
+        eeconfig_load();
+    }
+    return true;
+}
+#endif
+
 /** \brief eeconfig enable
  *
  * FIXME: needs doc
@@ -33,39 +133,47 @@ __attribute__((weak)) void eeconfig_init_kb(void) {
  * FIXME: needs doc
  */
 void eeconfig_init_quantum(void) {
+    // Drop pending writes so they can't overwrite the defaults below
+    eeconfig_dirty_count = 0;
 #ifdef STM32_EEPROM_ENABLE
     EEPROM_Erase();
 #endif
 #if defined(EEPROM_DRIVER)
     eeprom_driver_erase();
 #endif
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
-    eeprom_update_byte(EECONFIG_DEBUG, 0);
-    eeprom_update_byte(EECONFIG_DEFAULT_LAYER, 0);
+#if defined(EECONFIG_TRANSACTIONAL) && (defined(STM32_EEPROM_ENABLE) || defined(EEPROM_DRIVER))
+    // Reload the cache from the erased EEPROM
+    eeconfig_loaded = false;
+#endif
+    eeconfig_begin();
+    eeconfig_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+    eeconfig_update_byte(EECONFIG_DEBUG, 0);
+    eeconfig_update_byte(EECONFIG_DEFAULT_LAYER, 0);
     default_layer_state = 0;
-    eeprom_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, 0);
-    eeprom_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, 0);
-    eeprom_update_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
-    eeprom_update_byte(EECONFIG_BACKLIGHT, 0);
-    eeprom_update_byte(EECONFIG_AUDIO, 0xFF);  // On by default
-    eeprom_update_dword(EECONFIG_RGBLIGHT, 0);
-    eeprom_update_byte(EECONFIG_STENOMODE, 0);
-    eeprom_update_dword(EECONFIG_HAPTIC, 0);
-    eeprom_update_byte(EECONFIG_VELOCIKEY, 0);
-    eeprom_update_dword(EECONFIG_RGB_MATRIX, 0);
-    eeprom_update_byte(EECONFIG_RGB_MATRIX_SPEED, 0);
+    eeconfig_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, 0);
+    eeconfig_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, 0);
+    eeconfig_update_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
+    eeconfig_update_byte(EECONFIG_BACKLIGHT, 0);
+    eeconfig_update_byte(EECONFIG_AUDIO, 0xFF);  // On by default
+    eeconfig_update_dword(EECONFIG_RGBLIGHT, 0);
+    eeconfig_update_byte(EECONFIG_STENOMODE, 0);
+    eeconfig_update_dword(EECONFIG_HAPTIC, 0);
+    eeconfig_update_byte(EECONFIG_VELOCIKEY, 0);
+    eeconfig_update_dword(EECONFIG_RGB_MATRIX, 0);
+    eeconfig_update_byte(EECONFIG_RGB_MATRIX_SPEED, 0);
 
     // TODO: Remove once ARM has a way to configure EECONFIG_HANDEDNESS
     //        within the emulated eeprom via dfu-util or another tool
 #if defined INIT_EE_HANDS_LEFT
 #    pragma message "Faking EE_HANDS for left hand"
-    eeprom_update_byte(EECONFIG_HANDEDNESS, 1);
+    eeconfig_update_byte(EECONFIG_HANDEDNESS, 1);
 #elif defined INIT_EE_HANDS_RIGHT
 #    pragma message "Faking EE_HANDS for right hand"
-    eeprom_update_byte(EECONFIG_HANDEDNESS, 0);
+    eeconfig_update_byte(EECONFIG_HANDEDNESS, 0);
 #endif
 
     eeconfig_init_kb();
+    eeconfig_commit();
 }
 
 /** \brief eeconfig initialization
@@ -78,7 +186,7 @@ void eeconfig_init(void) { eeconfig_init_quantum(); }
  *
  * FIXME: needs doc
  */
-void eeconfig_enable(void) { eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER); }
+void eeconfig_enable(void) { eeconfig_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER); }
 
 /** \brief eeconfig disable
  *
@@ -91,119 +199,252 @@ void eeconfig_disable(void) {
 #if defined(EEPROM_DRIVER)
     eeprom_driver_erase();
 #endif
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER_OFF);
+#if defined(EECONFIG_TRANSACTIONAL) && (defined(STM32_EEPROM_ENABLE) || defined(EEPROM_DRIVER))
+    // Reload the cache from the erased EEPROM
+    eeconfig_loaded = false;
+#endif
+    eeconfig_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER_OFF);
 }
 
 /** \brief eeconfig is enabled
  *
  * FIXME: needs doc
  */
-bool eeconfig_is_enabled(void) { return (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER); }
+bool eeconfig_is_enabled(void) { return (eeconfig_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER); }
 
 /** \brief eeconfig is disabled
  *
  * FIXME: needs doc
  */
-bool eeconfig_is_disabled(void) { return (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER_OFF); }
+bool eeconfig_is_disabled(void) { return (eeconfig_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER_OFF); }
 
 /** \brief eeconfig read debug
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_debug(void) { return eeprom_read_byte(EECONFIG_DEBUG); }
+uint8_t eeconfig_read_debug(void) { return eeconfig_read_byte(EECONFIG_DEBUG); }
 /** \brief eeconfig update debug
  *
  * FIXME: needs doc
  */
-void eeconfig_update_debug(uint8_t val) { eeprom_update_byte(EECONFIG_DEBUG, val); }
+void eeconfig_update_debug(uint8_t val) { eeconfig_update_byte(EECONFIG_DEBUG, val); }
 
 /** \brief eeconfig read default layer
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_default_layer(void) { return eeprom_read_byte(EECONFIG_DEFAULT_LAYER); }
+uint8_t eeconfig_read_default_layer(void) { return eeconfig_read_byte(EECONFIG_DEFAULT_LAYER); }
 /** \brief eeconfig update default layer
  *
  * FIXME: needs doc
  */
-void eeconfig_update_default_layer(uint8_t val) { eeprom_update_byte(EECONFIG_DEFAULT_LAYER, val); }
+void eeconfig_update_default_layer(uint8_t val) { eeconfig_update_byte(EECONFIG_DEFAULT_LAYER, val); }
 
 /** \brief eeconfig read keymap
  *
  * FIXME: needs doc
  */
-uint16_t eeconfig_read_keymap(void) { return (eeprom_read_byte(EECONFIG_KEYMAP_LOWER_BYTE) | (eeprom_read_byte(EECONFIG_KEYMAP_UPPER_BYTE) << 8)); }
+uint16_t eeconfig_read_keymap(void) { return (eeconfig_read_byte(EECONFIG_KEYMAP_LOWER_BYTE) | (eeconfig_read_byte(EECONFIG_KEYMAP_UPPER_BYTE) << 8)); }
 /** \brief eeconfig update keymap
  *
  * FIXME: needs doc
  */
 void eeconfig_update_keymap(uint16_t val) {
-    eeprom_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, val & 0xFF);
-    eeprom_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, (val >> 8) & 0xFF);
+    eeconfig_begin();
+    eeconfig_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, val & 0xFF);
+    eeconfig_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, (val >> 8) & 0xFF);
+    eeconfig_commit();
 }
 
 /** \brief eeconfig read backlight
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_backlight(void) { return eeprom_read_byte(EECONFIG_BACKLIGHT); }
+uint8_t eeconfig_read_backlight(void) { return eeconfig_read_byte(EECONFIG_BACKLIGHT); }
 /** \brief eeconfig update backlight
  *
  * FIXME: needs doc
  */
-void eeconfig_update_backlight(uint8_t val) { eeprom_update_byte(EECONFIG_BACKLIGHT, val); }
+void eeconfig_update_backlight(uint8_t val) { eeconfig_update_byte(EECONFIG_BACKLIGHT, val); }
 
 /** \brief eeconfig read audio
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_audio(void) { return eeprom_read_byte(EECONFIG_AUDIO); }
+uint8_t eeconfig_read_audio(void) { return eeconfig_read_byte(EECONFIG_AUDIO); }
 /** \brief eeconfig update audio
  *
  * FIXME: needs doc
  */
-void eeconfig_update_audio(uint8_t val) { eeprom_update_byte(EECONFIG_AUDIO, val); }
+void eeconfig_update_audio(uint8_t val) { eeconfig_update_byte(EECONFIG_AUDIO, val); }
 
 /** \brief eeconfig read kb
  *
  * FIXME: needs doc
  */
-uint32_t eeconfig_read_kb(void) { return eeprom_read_dword(EECONFIG_KEYBOARD); }
+uint32_t eeconfig_read_kb(void) { return eeconfig_read_dword(EECONFIG_KEYBOARD); }
 /** \brief eeconfig update kb
  *
  * FIXME: needs doc
  */
-void eeconfig_update_kb(uint32_t val) { eeprom_update_dword(EECONFIG_KEYBOARD, val); }
+void eeconfig_update_kb(uint32_t val) { eeconfig_update_dword(EECONFIG_KEYBOARD, val); }
 
 /** \brief eeconfig read user
  *
  * FIXME: needs doc
  */
-uint32_t eeconfig_read_user(void) { return eeprom_read_dword(EECONFIG_USER); }
+uint32_t eeconfig_read_user(void) { return eeconfig_read_dword(EECONFIG_USER); }
 /** \brief eeconfig update user
  *
  * FIXME: needs doc
  */
-void eeconfig_update_user(uint32_t val) { eeprom_update_dword(EECONFIG_USER, val); }
+void eeconfig_update_user(uint32_t val) { eeconfig_update_dword(EECONFIG_USER, val); }
 
 /** \brief eeconfig read haptic
  *
  * FIXME: needs doc
  */
-uint32_t eeconfig_read_haptic(void) { return eeprom_read_dword(EECONFIG_HAPTIC); }
+uint32_t eeconfig_read_haptic(void) { return eeconfig_read_dword(EECONFIG_HAPTIC); }
 /** \brief eeconfig update haptic
  *
  * FIXME: needs doc
  */
-void eeconfig_update_haptic(uint32_t val) { eeprom_update_dword(EECONFIG_HAPTIC, val); }
+void eeconfig_update_haptic(uint32_t val) { eeconfig_update_dword(EECONFIG_HAPTIC, val); }
 
 /** \brief eeconfig read split handedness
  *
  * FIXME: needs doc
  */
-bool eeconfig_read_handedness(void) { return !!eeprom_read_byte(EECONFIG_HANDEDNESS); }
+bool eeconfig_read_handedness(void) { return !!eeconfig_read_byte(EECONFIG_HANDEDNESS); }
 /** \brief eeconfig update split handedness
  *
  * FIXME: needs doc
  */
-void eeconfig_update_handedness(bool val) { eeprom_update_byte(EECONFIG_HANDEDNESS, !!val); }
+void eeconfig_update_handedness(bool val) { eeconfig_update_byte(EECONFIG_HANDEDNESS, !!val); }
+
+#ifdef EECONFIG_TRANSACTIONAL
+/** \brief eeconfig migrate
+ *
+ * Called once when the stored config block is older than EECONFIG_VERSION,
+ * before it is committed with the current version.
+ */
+__attribute__((weak)) void eeconfig_migrate_user(uint8_t from_version) {}
+
+__attribute__((weak)) void eeconfig_migrate_kb(uint8_t from_version) { eeconfig_migrate_user(from_version); }
+
+/** \brief eeconfig begin
+ *
+ * Starts a transaction, updates are kept in RAM until the matching eeconfig_commit().
+ */
+void eeconfig_begin(void) { eeconfig_txn_depth++; }
+
+/** \brief eeconfig commit
+ *
+ * Ends a transaction, writing the config block once the outermost one ends.
+ */
+void eeconfig_commit(void) {
+    if (eeconfig_txn_depth > 0 && --eeconfig_txn_depth > 0) {
+        return;
+    }
+    if (eeconfig_cache_dirty) {
+        eeconfig_store();
+    }
+}
+
+/** \brief eeconfig read block
+ *
+ * Reads from the RAM copy of the config block, or from EEPROM past it.
+ */
+void eeconfig_read_block(void *buf, const void *addr, size_t len) {
+    if (eeconfig_cached(addr, len)) {
+        memcpy(buf, &eeconfig_cache[(uintptr_t)addr], len);
+    } else {
+        eeprom_read_block(buf, addr, len);
+    }
+}
+
+uint8_t eeconfig_read_byte(const uint8_t *addr) {
+    uint8_t val;
+    eeconfig_read_block(&val, addr, sizeof(val));
+    return val;
+}
+
+uint16_t eeconfig_read_word(const uint16_t *addr) {
+    uint16_t val;
+    eeconfig_read_block(&val, addr, sizeof(val));
+    return val;
+}
+
+uint32_t eeconfig_read_dword(const uint32_t *addr) {
+    uint32_t val;
+    eeconfig_read_block(&val, addr, sizeof(val));
+    return val;
+}
+
+/** \brief eeconfig update block
+ *
+ * Updates the RAM copy of the config block and commits it unless a
+ * transaction is open, addresses past the block go straight to EEPROM.
+ */
+void eeconfig_update_block(const void *buf, void *addr, size_t len) {
+    if (!eeconfig_cached(addr, len)) {
+        eeprom_update_block(buf, addr, len);
+        return;
+    }
+    if (memcmp(&eeconfig_cache[(uintptr_t)addr], buf, len) != 0) {
+        memcpy(&eeconfig_cache[(uintptr_t)addr], buf, len);
+        eeconfig_cache_dirty = true;
+    }
+    if (eeconfig_txn_depth == 0 && eeconfig_cache_dirty) {
+        eeconfig_store();
+    }
+}
+
+void eeconfig_update_byte(uint8_t *addr, uint8_t val) { eeconfig_update_block(&val, addr, sizeof(val)); }
+
+void eeconfig_update_word(uint16_t *addr, uint16_t val) { eeconfig_update_block(&val, addr, sizeof(val)); }
+
+void eeconfig_update_dword(uint32_t *addr, uint32_t val) { eeconfig_update_block(&val, addr, sizeof(val)); }
+#endif
+
+/** \brief eeconfig mark dirty
+ *
+ * Queues flush to be called once no config has been marked dirty for
+ * EECONFIG_DEFERRED_WRITE_DELAY ms, so repeated changes reach EEPROM as one write.
+ */
+void eeconfig_mark_dirty(eeconfig_flush_f flush) {
+    eeconfig_dirty_timer = timer_read();
+    for (uint8_t i = 0; i < eeconfig_dirty_count; i++) {
+        if (eeconfig_dirty[i] == flush) {
+            return;
+        }
+    }
+    if (eeconfig_dirty_count < EECONFIG_DEFERRED_WRITE_SLOTS) {
+        eeconfig_dirty[eeconfig_dirty_count++] = flush;
+    } else {
+        // No room to defer it, so write it now
+        flush();
+    }
+}
+
+/** \brief eeconfig flush
+ *
+ * Writes every pending config block now.
+ */
+void eeconfig_flush(void) {
+    for (uint8_t i = 0; i < eeconfig_dirty_count; i++) {
+        eeconfig_dirty[i]();
+        telemetry_count(TELEMETRY_EEPROM_WRITES);
+    }
+    eeconfig_dirty_count = 0;
+}
+
+/** \brief eeconfig task
+ *
+ * Writes the pending config blocks once the quiet period has passed.
+ */
+void eeconfig_task(void) {
+    if (eeconfig_dirty_count > 0 && timer_elapsed(eeconfig_dirty_timer) >= EECONFIG_DEFERRED_WRITE_DELAY) {
+        eeconfig_flush();
+    }
+}
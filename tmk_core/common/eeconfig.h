@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifndef EECONFIG_MAGIC_NUMBER
 #    define EECONFIG_MAGIC_NUMBER (uint16_t)0xFEEC
@@ -48,8 +49,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define EECONFIG_RGB_MATRIX_SPEED (uint8_t *)32
 // TODO: Combine these into a single word and single block of EEPROM
 #define EECONFIG_KEYMAP_UPPER_BYTE (uint8_t *)33
+// Size of the config block itself
+#define EECONFIG_BASE_SIZE 34
+// Layout version stored with the config block, bump when the layout changes
+#define EECONFIG_VERSION 1
+#ifdef EECONFIG_TRANSACTIONAL
+// Every copy of the config block is followed by a version byte and a CRC-16
+#    define EECONFIG_FOOTER_SIZE 3
+#    define EECONFIG_FOOTER (uint8_t *)EECONFIG_BASE_SIZE
+#    define EECONFIG_SHADOW (uint8_t *)(EECONFIG_BASE_SIZE + EECONFIG_FOOTER_SIZE)
+#    define EECONFIG_SHADOW_FOOTER (uint8_t *)(2 * EECONFIG_BASE_SIZE + EECONFIG_FOOTER_SIZE)
 // Size of EEPROM being used, other code can refer to this for available EEPROM
-#define EECONFIG_SIZE 34
+#    define EECONFIG_SIZE (2 * (EECONFIG_BASE_SIZE + EECONFIG_FOOTER_SIZE))
+#else
+// Size of EEPROM being used, other code can refer to this for available EEPROM
+#    define EECONFIG_SIZE EECONFIG_BASE_SIZE
+#endif
 /* debug bit */
 #define EECONFIG_DEBUG_ENABLE (1 << 0)
 #define EECONFIG_DEBUG_MATRIX (1 << 1)
@@ -112,4 +127,39 @@ void     eeconfig_update_haptic(uint32_t val);
 bool eeconfig_read_handedness(void);
 void eeconfig_update_handedness(bool val);
 
+#ifdef EECONFIG_TRANSACTIONAL
+uint8_t  eeconfig_read_byte(const uint8_t *addr);
+uint16_t eeconfig_read_word(const uint16_t *addr);
+uint32_t eeconfig_read_dword(const uint32_t *addr);
+void     eeconfig_read_block(void *buf, const void *addr, size_t len);
+void     eeconfig_update_byte(uint8_t *addr, uint8_t val);
+void     eeconfig_update_word(uint16_t *addr, uint16_t val);
+void     eeconfig_update_dword(uint32_t *addr, uint32_t val);
+void     eeconfig_update_block(const void *buf, void *addr, size_t len);
+
+void eeconfig_begin(void);
+void eeconfig_commit(void);
+
+void eeconfig_migrate_kb(uint8_t from_version);
+void eeconfig_migrate_user(uint8_t from_version);
+#else
+#    include "eeprom.h"
+#    define eeconfig_read_byte eeprom_read_byte
+#    define eeconfig_read_word eeprom_read_word
+#    define eeconfig_read_dword eeprom_read_dword
+#    define eeconfig_read_block eeprom_read_block
+#    define eeconfig_update_byte eeprom_update_byte
+#    define eeconfig_update_word eeprom_update_word
+#    define eeconfig_update_dword eeprom_update_dword
+#    define eeconfig_update_block eeprom_update_block
+#    define eeconfig_begin()
+#    define eeconfig_commit()
+#endif
+
+typedef void (*eeconfig_flush_f)(void);
+
+void eeconfig_mark_dirty(eeconfig_flush_f flush);
+void eeconfig_flush(void);
+void eeconfig_task(void);
+
 #endif
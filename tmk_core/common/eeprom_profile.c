@@ -0,0 +1,259 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "eeprom.h"
+#include "eeprom_profile.h"
+#include "eeconfig.h"
+#include "timer.h"
+#include "print.h"
+
+/*
+    The linker is passed --wrap for every eeprom_* function, so calls from other
+    objects land in the __wrap_ functions below, which count the call and forward
+    it to the real implementation through __real_.
+
+    Implementations built on top of each other (eeprom_update_block() reading and
+    writing blocks, for instance) would be counted more than once, so only the
+    outermost call is counted.
+*/
+
+uint8_t  __real_eeprom_read_byte(const uint8_t *addr);
+uint16_t __real_eeprom_read_word(const uint16_t *addr);
+uint32_t __real_eeprom_read_dword(const uint32_t *addr);
+void     __real_eeprom_read_block(void *buf, const void *addr, size_t len);
+void     __real_eeprom_write_byte(uint8_t *addr, uint8_t value);
+void     __real_eeprom_write_word(uint16_t *addr, uint16_t value);
+void     __real_eeprom_write_dword(uint32_t *addr, uint32_t value);
+void     __real_eeprom_write_block(const void *buf, void *addr, size_t len);
+void     __real_eeprom_update_byte(uint8_t *addr, uint8_t value);
+void     __real_eeprom_update_word(uint16_t *addr, uint16_t value);
+void     __real_eeprom_update_dword(uint32_t *addr, uint32_t value);
+void     __real_eeprom_update_block(const void *buf, void *addr, size_t len);
+
+static eeprom_profile_t eeprom_profile[EEPROM_PROFILE_REGION_COUNT];
+static uint8_t          eeprom_profile_depth = 0;
+
+#ifdef EEPROM_PROFILE_PERSIST_ADDR
+static bool eeprom_profile_loaded = false;
+
+static void eeprom_profile_load(void) {
+    eeprom_profile_loaded = true;
+    for (uint8_t i = 0; i < EEPROM_PROFILE_REGION_COUNT; i++) {
+        uint32_t lifetime_writes = __real_eeprom_read_dword((const uint32_t *)(EEPROM_PROFILE_PERSIST_ADDR) + i);
+        // Treat erased EEPROM as no writes yet
+        eeprom_profile[i].lifetime_writes = lifetime_writes == UINT32_MAX ? 0 : lifetime_writes;
+    }
+}
+
+static void eeprom_profile_save(void) {
+    eeprom_profile_depth++;
+    for (uint8_t i = 0; i < EEPROM_PROFILE_REGION_COUNT; i++) {
+        __real_eeprom_update_dword((uint32_t *)(EEPROM_PROFILE_PERSIST_ADDR) + i, eeprom_profile[i].lifetime_writes);
+    }
+    eeprom_profile_depth--;
+}
+#endif
+
+static uint8_t eeprom_profile_region(const void *addr) {
+    uintptr_t p = (uintptr_t)addr;
+    if (p >= (uintptr_t)EECONFIG_RGBLIGHT && p < (uintptr_t)EECONFIG_RGBLIGHT + sizeof(uint32_t)) {
+        return EEPROM_PROFILE_RGBLIGHT;
+    }
+    if (p >= (uintptr_t)EECONFIG_RGB_MATRIX && p <= (uintptr_t)EECONFIG_RGB_MATRIX_SPEED) {
+        return EEPROM_PROFILE_RGB_MATRIX;
+    }
+    if (p < EECONFIG_SIZE) {
+        return EEPROM_PROFILE_EECONFIG;
+    }
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    return eeprom_profile_dynamic_keymap_region(p);
+#else
+    return EEPROM_PROFILE_OTHER;
+#endif
+}
+
+static void eeprom_profile_read(const void *addr, size_t len, uint32_t start) {
+    eeprom_profile_t *profile = &eeprom_profile[eeprom_profile_region(addr)];
+    profile->reads++;
+    profile->read_bytes += len;
+    profile->time += timer_elapsed32(start);
+}
+
+static void eeprom_profile_write(const void *addr, size_t len, uint32_t start) {
+    eeprom_profile_t *profile = &eeprom_profile[eeprom_profile_region(addr)];
+    profile->writes++;
+    profile->write_bytes += len;
+    profile->time += timer_elapsed32(start);
+#ifdef EEPROM_PROFILE_PERSIST_ADDR
+    if (!eeprom_profile_loaded) {
+        eeprom_profile_load();
+    }
+    profile->lifetime_writes++;
+    eeconfig_mark_dirty(eeprom_profile_save);
+#endif
+}
+
+static void eeprom_profile_skip(const void *addr, uint32_t start) {
+    eeprom_profile_t *profile = &eeprom_profile[eeprom_profile_region(addr)];
+    profile->skipped++;
+    profile->time += timer_elapsed32(start);
+}
+
+static bool eeprom_profile_block_changed(const void *buf, const void *addr, size_t len) {
+    uint8_t        chunk[16];
+    const uint8_t *source = (const uint8_t *)buf;
+    uintptr_t      p      = (uintptr_t)addr;
+    while (len > 0) {
+        size_t chunk_length = len < sizeof(chunk) ? len : sizeof(chunk);
+        __real_eeprom_read_block(chunk, (const void *)p, chunk_length);
+        if (memcmp(source, chunk, chunk_length) != 0) {
+            return true;
+        }
+        source += chunk_length;
+        p += chunk_length;
+        len -= chunk_length;
+    }
+    return false;
+}
+
+#define EEPROM_PROFILE_READ(type, name, len)           \
+    type __wrap_eeprom_read_##name(const type *addr) { \
+        if (eeprom_profile_depth > 0) {                \
+            return __real_eeprom_read_##name(addr);    \
+        }                                              \
+        uint32_t start = timer_read32();               \
+        eeprom_profile_depth++;                        \
+        type ret = __real_eeprom_read_##name(addr);    \
+        eeprom_profile_depth--;                        \
+        eeprom_profile_read(addr, len, start);         \
+        return ret;                                    \
+    }
+
+#define EEPROM_PROFILE_WRITE(type, name, len)                 \
+    void __wrap_eeprom_write_##name(type *addr, type value) { \
+        if (eeprom_profile_depth > 0) {                       \
+            __real_eeprom_write_##name(addr, value);          \
+            return;                                           \
+        }                                                     \
+        uint32_t start = timer_read32();                      \
+        eeprom_profile_depth++;                               \
+        __real_eeprom_write_##name(addr, value);              \
+        eeprom_profile_depth--;                               \
+        eeprom_profile_write(addr, len, start);               \
+    }
+
+#define EEPROM_PROFILE_UPDATE(type, name, len)                       \
+    void __wrap_eeprom_update_##name(type *addr, type value) {       \
+        if (eeprom_profile_depth > 0) {                              \
+            __real_eeprom_update_##name(addr, value);                \
+            return;                                                  \
+        }                                                            \
+        eeprom_profile_depth++;                                      \
+        bool     changed = __real_eeprom_read_##name(addr) != value; \
+        uint32_t start   = timer_read32();                           \
+        __real_eeprom_update_##name(addr, value);                    \
+        eeprom_profile_depth--;                                      \
+        if (changed) {                                               \
+            eeprom_profile_write(addr, len, start);                  \
+        } else {                                                     \
+            eeprom_profile_skip(addr, start);                        \
+        }                                                            \
+    }
+
+EEPROM_PROFILE_READ(uint8_t, byte, 1)
+EEPROM_PROFILE_READ(uint16_t, word, 2)
+EEPROM_PROFILE_READ(uint32_t, dword, 4)
+EEPROM_PROFILE_WRITE(uint8_t, byte, 1)
+EEPROM_PROFILE_WRITE(uint16_t, word, 2)
+EEPROM_PROFILE_WRITE(uint32_t, dword, 4)
+EEPROM_PROFILE_UPDATE(uint8_t, byte, 1)
+EEPROM_PROFILE_UPDATE(uint16_t, word, 2)
+EEPROM_PROFILE_UPDATE(uint32_t, dword, 4)
+
+void __wrap_eeprom_read_block(void *buf, const void *addr, size_t len) {
+    if (eeprom_profile_depth > 0) {
+        __real_eeprom_read_block(buf, addr, len);
+        return;
+    }
+    uint32_t start = timer_read32();
+    eeprom_profile_depth++;
+    __real_eeprom_read_block(buf, addr, len);
+    eeprom_profile_depth--;
+    eeprom_profile_read(addr, len, start);
+}
+
+void __wrap_eeprom_write_block(const void *buf, void *addr, size_t len) {
+    if (eeprom_profile_depth > 0) {
+        __real_eeprom_write_block(buf, addr, len);
+        return;
+    }
+    uint32_t start = timer_read32();
+    eeprom_profile_depth++;
+    __real_eeprom_write_block(buf, addr, len);
+    eeprom_profile_depth--;
+    eeprom_profile_write(addr, len, start);
+}
+
+void __wrap_eeprom_update_block(const void *buf, void *addr, size_t len) {
+    if (eeprom_profile_depth > 0) {
+        __real_eeprom_update_block(buf, addr, len);
+        return;
+    }
+    eeprom_profile_depth++;
+    bool     changed = eeprom_profile_block_changed(buf, addr, len);
+    uint32_t start   = timer_read32();
+    __real_eeprom_update_block(buf, addr, len);
+    eeprom_profile_depth--;
+    if (changed) {
+        eeprom_profile_write(addr, len, start);
+    } else {
+        eeprom_profile_skip(addr, start);
+    }
+}
+
+const eeprom_profile_t *eeprom_profile_get(uint8_t region) {
+    if (region >= EEPROM_PROFILE_REGION_COUNT) {
+        return NULL;
+    }
+#ifdef EEPROM_PROFILE_PERSIST_ADDR
+    if (!eeprom_profile_loaded) {
+        eeprom_profile_load();
+    }
+#endif
+    return &eeprom_profile[region];
+}
+
+void eeprom_profile_reset(void) {
+    for (uint8_t i = 0; i < EEPROM_PROFILE_REGION_COUNT; i++) {
+        uint32_t lifetime_writes = eeprom_profile_get(i)->lifetime_writes;
+        memset(&eeprom_profile[i], 0, sizeof(eeprom_profile_t));
+        eeprom_profile[i].lifetime_writes = lifetime_writes;
+    }
+}
+
+void eeprom_profile_print(void) {
+#ifndef NO_PRINT
+    static const char *const names[EEPROM_PROFILE_REGION_COUNT] = {"eeconfig", "rgblight", "rgb_matrix", "via", "dynamic_keymap", "macro", "other"};
+    uprintf("EEPROM profile: region reads/bytes writes/bytes skipped ms lifetime\n");
+    for (uint8_t i = 0; i < EEPROM_PROFILE_REGION_COUNT; i++) {
+        const eeprom_profile_t *profile = eeprom_profile_get(i);
+        uprintf("%s: %lu/%lu %lu/%lu %lu %lu %lu\n", names[i], profile->reads, profile->read_bytes, profile->writes, profile->write_bytes, profile->skipped, profile->time, profile->lifetime_writes);
+    }
+#endif
+}
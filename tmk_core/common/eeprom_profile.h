@@ -0,0 +1,55 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* EEPROM access profiler
+ *
+ * With EEPROM_PROFILE_ENABLE = yes the eeprom_* calls are wrapped at link time
+ * and counted against the region of EEPROM they address.
+ */
+
+enum eeprom_profile_region {
+    EEPROM_PROFILE_EECONFIG = 0,
+    EEPROM_PROFILE_RGBLIGHT,
+    EEPROM_PROFILE_RGB_MATRIX,
+    EEPROM_PROFILE_VIA,
+    EEPROM_PROFILE_DYNAMIC_KEYMAP,
+    EEPROM_PROFILE_MACRO,
+    EEPROM_PROFILE_OTHER,
+    EEPROM_PROFILE_REGION_COUNT,
+};
+
+typedef struct {
+    uint32_t reads;            // read calls
+    uint32_t read_bytes;       // bytes read
+    uint32_t writes;           // write and update calls that changed EEPROM
+    uint32_t write_bytes;      // bytes written by those calls
+    uint32_t skipped;          // update calls that found EEPROM already up to date
+    uint32_t time;             // milliseconds spent in all of the above
+    uint32_t lifetime_writes;  // writes, persisted across resets with EEPROM_PROFILE_PERSIST_ADDR
+} eeprom_profile_t;
+
+const eeprom_profile_t *eeprom_profile_get(uint8_t region);
+void                    eeprom_profile_reset(void);
+void                    eeprom_profile_print(void);
+
+#ifdef DYNAMIC_KEYMAP_ENABLE
+// Provided by dynamic_keymap.c, which knows where its data lives
+uint8_t eeprom_profile_dynamic_keymap_region(uintptr_t addr);
+#endif
@@ -16,6 +16,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdint.h>
+#include <string.h>
 //#include <avr/interrupt.h>
 #include "keycode.h"
 #include "host.h"
@@ -30,8 +31,20 @@ extern keymap_config_t keymap_config;
 static host_driver_t *driver;
 static uint16_t       last_system_report   = 0;
 static uint16_t       last_consumer_report = 0;
+// Last keyboard report sent, and the protocol it was sent with, so repeats can be skipped
+static report_keyboard_t last_keyboard_report;
+static uint8_t           last_keyboard_protocol = 0xFF;
+#ifdef HOST_REPORT_STATS
+static host_report_stats_t report_stats;
+#endif
+
+void host_set_driver(host_driver_t *d) {
+    driver = d;
+    // A new driver hasn't seen any keyboard report yet
+    host_keyboard_report_lost();
+}
 
-void host_set_driver(host_driver_t *d) { driver = d; }
+void host_keyboard_report_lost(void) { last_keyboard_protocol = 0xFF; }
 
 host_driver_t *host_get_driver(void) { return driver; }
 
@@ -62,6 +75,26 @@ void host_keyboard_send(report_keyboard_t *report) {
         report->report_id = REPORT_ID_KEYBOARD;
 #endif
     }
+
+    // The host already has this state, so don't spend an IN transfer on it
+    uint8_t protocol = 0;
+#ifdef NKRO_ENABLE
+    // The same bytes mean something else once the report layout switches
+    protocol = keyboard_protocol | (keymap_config.nkro << 1);
+#endif
+    if (protocol == last_keyboard_protocol && memcmp(report, &last_keyboard_report, sizeof(report_keyboard_t)) == 0) {
+#ifdef HOST_REPORT_STATS
+        report_stats.keyboard_suppressed++;
+#endif
+        return;
+    }
+    last_keyboard_report   = *report;
+    last_keyboard_protocol = protocol;
+#ifdef HOST_REPORT_STATS
+    report_stats.keyboard_sent++;
+#endif
+
+    // Drivers that drop the report call host_keyboard_report_lost(), so it isn't taken as sent
     (*driver->send_keyboard)(report);
 
     if (debug_keyboard) {
@@ -82,21 +115,43 @@ void host_mouse_send(report_mouse_t *report) {
 }
 
 void host_system_send(uint16_t report) {
-    if (report == last_system_report) return;
+    if (report == last_system_report) {
+#ifdef HOST_REPORT_STATS
+        report_stats.system_suppressed++;
+#endif
+        return;
+    }
     last_system_report = report;
 
     if (!driver) return;
+#ifdef HOST_REPORT_STATS
+    report_stats.system_sent++;
+#endif
     (*driver->send_system)(report);
 }
 
 void host_consumer_send(uint16_t report) {
-    if (report == last_consumer_report) return;
+    if (report == last_consumer_report) {
+#ifdef HOST_REPORT_STATS
+        report_stats.consumer_suppressed++;
+#endif
+        return;
+    }
     last_consumer_report = report;
 
     if (!driver) return;
+#ifdef HOST_REPORT_STATS
+    report_stats.consumer_sent++;
+#endif
     (*driver->send_consumer)(report);
 }
 
 uint16_t host_last_system_report(void) { return last_system_report; }
 
 uint16_t host_last_consumer_report(void) { return last_consumer_report; }
+
+#ifdef HOST_REPORT_STATS
+void host_get_report_stats(host_report_stats_t *stats) { *stats = report_stats; }
+
+void host_clear_report_stats(void) { memset(&report_stats, 0, sizeof(report_stats)); }
+#endif
@@ -47,10 +47,28 @@ void    host_keyboard_send(report_keyboard_t *report);
 void    host_mouse_send(report_mouse_t *report);
 void    host_system_send(uint16_t data);
 void    host_consumer_send(uint16_t data);
+/* send the next keyboard report even if it repeats the last one, for drivers that
+ * dropped a report or whose host may have lost track of the keyboard's state */
+void host_keyboard_report_lost(void);
 
 uint16_t host_last_system_report(void);
 uint16_t host_last_consumer_report(void);
 
+#ifdef HOST_REPORT_STATS
+/* reports passed to the driver, and repeats of the last report that were skipped */
+typedef struct {
+    uint32_t keyboard_sent;
+    uint32_t keyboard_suppressed;
+    uint32_t system_sent;
+    uint32_t system_suppressed;
+    uint32_t consumer_sent;
+    uint32_t consumer_suppressed;
+} host_report_stats_t;
+
+void host_get_report_stats(host_report_stats_t *stats);
+void host_clear_report_stats(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
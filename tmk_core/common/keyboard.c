@@ -92,6 +92,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef VIA_ENABLE
 #    include "via.h"
 #endif
+#ifdef DYNAMIC_KEYMAP_ENABLE
+#    include "dynamic_keymap.h"
+#endif
 #ifdef DIP_SWITCH_ENABLE
 #    include "dip_switch.h"
 #endif
@@ -238,6 +241,8 @@ void keyboard_init(void) {
     matrix_init();
 #ifdef VIA_ENABLE
     via_init();
+#elif defined(DYNAMIC_KEYMAP_ENABLE)
+    dynamic_keymap_init();
 #endif
 #ifdef QWIIC_ENABLE
     qwiic_init();
@@ -413,6 +418,8 @@ MATRIX_LOOP_END:
     pointing_device_task();
 #endif
 
+    eeconfig_task();
+
 #ifdef MIDI_ENABLE
     midi_task();
 #endif
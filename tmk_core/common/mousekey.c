@@ -16,6 +16,7 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 #include "keycode.h"
 #include "host.h"
 #include "timer.h"
@@ -37,7 +38,212 @@ static uint8_t        mousekey_accel        = 0;
 static uint8_t        mousekey_repeat       = 0;
 static uint8_t        mousekey_wheel_repeat = 0;
 
-#ifndef MK_3_SPEED
+#ifdef MK_KINETIC
+
+enum { mk_axis_x, mk_axis_y, mk_axis_v, mk_axis_h, mk_axis_COUNT };
+
+/* direction held on each axis, -1, 0 or 1, the last key pressed wins */
+static int8_t   mk_dir[mk_axis_COUNT];
+/* movement not yet reported, in thousandths of a pixel or scroll step */
+static int32_t  mk_accum[mk_axis_COUNT];
+static uint16_t mk_move_start  = 0;
+static uint16_t mk_wheel_start = 0;
+static uint16_t mk_last_frame  = 0;
+
+/*
+ * Shape of the acceleration from the initial to the maximum speed,
+ * progress and result are 0-256
+ */
+static uint16_t mk_curve(uint16_t progress) {
+#    if MK_KINETIC_CURVE == MK_CURVE_LINEAR
+    return progress;
+#    elif MK_KINETIC_CURVE == MK_CURVE_QUADRATIC
+    return ((uint32_t)progress * progress) >> 8;
+#    else
+    // (2^(k*p) - 1) / (2^k - 1), with 2^f for the fraction f approximated by 1 + 0.656f + 0.344f^2
+    uint16_t x     = progress * MK_KINETIC_CURVE_SCALE;
+    uint16_t f     = x & 0xFF;
+    // Widened before multiplying and shifting, as 2^8 << 8 and 255 * 255 overflow a 16-bit int
+    uint32_t pow2  = (256 + (((uint32_t)f * (168 + ((88 * f) >> 8))) >> 8)) << (x >> 8);
+    uint32_t range = (256UL << MK_KINETIC_CURVE_SCALE) - 256;
+    return ((pow2 - 256) << 8) / range;
+#    endif
+}
+
+/* speed in pixels or scroll steps per second after being held for the given time */
+static uint16_t mk_speed(uint16_t held, uint16_t initial, uint16_t max, uint16_t time_to_max) {
+    if (mousekey_accel & (1 << 0)) {
+        return max / 4;
+    } else if (mousekey_accel & (1 << 1)) {
+        return max / 2;
+    } else if (mousekey_accel & (1 << 2)) {
+        return max;
+    }
+    uint16_t progress = held >= time_to_max ? 256 : ((uint32_t)held << 8) / time_to_max;
+    return initial + (((uint32_t)(max - initial) * mk_curve(progress)) >> 8);
+}
+
+/* move a pair of axes for one frame, scaling diagonals by 1/sqrt(2) */
+static void mk_integrate(uint8_t a, uint8_t b, uint16_t speed, uint16_t elapsed) {
+    uint32_t step = (uint32_t)speed * elapsed;
+    if (mk_dir[a] && mk_dir[b]) {
+        step = (step * 181 + 128) >> 8;
+    }
+    mk_accum[a] += mk_dir[a] * (int32_t)step;
+    mk_accum[b] += mk_dir[b] * (int32_t)step;
+}
+
+/* take the whole pixels or steps out of an accumulator, keeping the fraction */
+static int8_t mk_take(uint8_t axis, int8_t max) {
+    int32_t whole = mk_accum[axis] / 1000;
+    if (whole > max || whole < -max) {
+        // Faster than a report can carry, drop the excess rather than let it build up
+        whole = whole > 0 ? max : -max;
+        mk_accum[axis] %= 1000;
+    } else {
+        mk_accum[axis] -= whole * 1000;
+    }
+    return whole;
+}
+
+void mousekey_task(void) {
+    bool moving    = mk_dir[mk_axis_x] || mk_dir[mk_axis_y];
+    bool scrolling = mk_dir[mk_axis_v] || mk_dir[mk_axis_h];
+    if (!moving && !scrolling) {
+        return;
+    }
+
+    // Integrate over the time that actually passed, so the speed doesn't depend on how often this runs
+    uint16_t now     = timer_read();
+    uint16_t elapsed = TIMER_DIFF_16(now, mk_last_frame);
+    if (elapsed < MK_KINETIC_FRAME) {
+        return;
+    }
+    mk_last_frame = now;
+    if (elapsed > MK_KINETIC_MAX_STEP) {
+        // Don't jump after the loop was stalled
+        elapsed = MK_KINETIC_MAX_STEP;
+    }
+
+    if (moving) {
+        mk_integrate(mk_axis_x, mk_axis_y, mk_speed(TIMER_DIFF_16(now, mk_move_start), MK_KINETIC_INITIAL_SPEED, MK_KINETIC_MAX_SPEED, MK_KINETIC_TIME_TO_MAX), elapsed);
+    }
+    if (scrolling) {
+        mk_integrate(mk_axis_v, mk_axis_h, mk_speed(TIMER_DIFF_16(now, mk_wheel_start), MK_KINETIC_WHEEL_INITIAL_SPEED, MK_KINETIC_WHEEL_MAX_SPEED, MK_KINETIC_WHEEL_TIME_TO_MAX), elapsed);
+    }
+
+    mouse_report.x = mk_take(mk_axis_x, MOUSEKEY_MOVE_MAX);
+    mouse_report.y = mk_take(mk_axis_y, MOUSEKEY_MOVE_MAX);
+    mouse_report.v = mk_take(mk_axis_v, MOUSEKEY_WHEEL_MAX);
+    mouse_report.h = mk_take(mk_axis_h, MOUSEKEY_WHEEL_MAX);
+    if (mouse_report.x || mouse_report.y || mouse_report.v || mouse_report.h) {
+        mousekey_send();
+    }
+    mouse_report.x = 0;
+    mouse_report.y = 0;
+    mouse_report.v = 0;
+    mouse_report.h = 0;
+}
+
+static void mk_press(uint8_t axis, int8_t dir) {
+    uint16_t now       = timer_read();
+    bool     moving    = mk_dir[mk_axis_x] || mk_dir[mk_axis_y];
+    bool     scrolling = mk_dir[mk_axis_v] || mk_dir[mk_axis_h];
+    if (!moving && !scrolling) {
+        // Nothing was moving, so the first frame is due now
+        mk_last_frame = now - MK_KINETIC_FRAME;
+    }
+    // Acceleration starts over once all keys of the cursor or the wheel were released
+    if (axis <= mk_axis_y && !moving) {
+        mk_move_start = now;
+    } else if (axis >= mk_axis_v && !scrolling) {
+        mk_wheel_start = now;
+    }
+    if (mk_dir[axis] != dir) {
+        // Start just short of a whole step, so a tap always moves by one
+        mk_accum[axis] = dir * 999;
+    }
+    mk_dir[axis] = dir;
+}
+
+static void mk_release(uint8_t axis, int8_t dir) {
+    if (mk_dir[axis] == dir) {
+        mk_dir[axis]   = 0;
+        mk_accum[axis] = 0;
+    }
+}
+
+void mousekey_on(uint8_t code) {
+    if (code == KC_MS_UP)
+        mk_press(mk_axis_y, -1);
+    else if (code == KC_MS_DOWN)
+        mk_press(mk_axis_y, 1);
+    else if (code == KC_MS_LEFT)
+        mk_press(mk_axis_x, -1);
+    else if (code == KC_MS_RIGHT)
+        mk_press(mk_axis_x, 1);
+    else if (code == KC_MS_WH_UP)
+        mk_press(mk_axis_v, 1);
+    else if (code == KC_MS_WH_DOWN)
+        mk_press(mk_axis_v, -1);
+    else if (code == KC_MS_WH_LEFT)
+        mk_press(mk_axis_h, -1);
+    else if (code == KC_MS_WH_RIGHT)
+        mk_press(mk_axis_h, 1);
+    else if (code == KC_MS_BTN1)
+        mouse_report.buttons |= MOUSE_BTN1;
+    else if (code == KC_MS_BTN2)
+        mouse_report.buttons |= MOUSE_BTN2;
+    else if (code == KC_MS_BTN3)
+        mouse_report.buttons |= MOUSE_BTN3;
+    else if (code == KC_MS_BTN4)
+        mouse_report.buttons |= MOUSE_BTN4;
+    else if (code == KC_MS_BTN5)
+        mouse_report.buttons |= MOUSE_BTN5;
+    else if (code == KC_MS_ACCEL0)
+        mousekey_accel |= (1 << 0);
+    else if (code == KC_MS_ACCEL1)
+        mousekey_accel |= (1 << 1);
+    else if (code == KC_MS_ACCEL2)
+        mousekey_accel |= (1 << 2);
+}
+
+void mousekey_off(uint8_t code) {
+    if (code == KC_MS_UP)
+        mk_release(mk_axis_y, -1);
+    else if (code == KC_MS_DOWN)
+        mk_release(mk_axis_y, 1);
+    else if (code == KC_MS_LEFT)
+        mk_release(mk_axis_x, -1);
+    else if (code == KC_MS_RIGHT)
+        mk_release(mk_axis_x, 1);
+    else if (code == KC_MS_WH_UP)
+        mk_release(mk_axis_v, 1);
+    else if (code == KC_MS_WH_DOWN)
+        mk_release(mk_axis_v, -1);
+    else if (code == KC_MS_WH_LEFT)
+        mk_release(mk_axis_h, -1);
+    else if (code == KC_MS_WH_RIGHT)
+        mk_release(mk_axis_h, 1);
+    else if (code == KC_MS_BTN1)
+        mouse_report.buttons &= ~MOUSE_BTN1;
+    else if (code == KC_MS_BTN2)
+        mouse_report.buttons &= ~MOUSE_BTN2;
+    else if (code == KC_MS_BTN3)
+        mouse_report.buttons &= ~MOUSE_BTN3;
+    else if (code == KC_MS_BTN4)
+        mouse_report.buttons &= ~MOUSE_BTN4;
+    else if (code == KC_MS_BTN5)
+        mouse_report.buttons &= ~MOUSE_BTN5;
+    else if (code == KC_MS_ACCEL0)
+        mousekey_accel &= ~(1 << 0);
+    else if (code == KC_MS_ACCEL1)
+        mousekey_accel &= ~(1 << 1);
+    else if (code == KC_MS_ACCEL2)
+        mousekey_accel &= ~(1 << 2);
+}
+
+#elif !defined(MK_3_SPEED)
 
 static uint16_t last_timer_c = 0;
 static uint16_t last_timer_w = 0;
@@ -264,7 +470,7 @@ void mousekey_off(uint8_t code) {
     if (mouse_report.v == 0 && mouse_report.h == 0) mousekey_wheel_repeat = 0;
 }
 
-#else /* #ifndef MK_3_SPEED */
+#else /* #ifdef MK_KINETIC */
 
 enum { mkspd_unmod, mkspd_0, mkspd_1, mkspd_2, mkspd_COUNT };
 #    ifndef MK_MOMENTARY_ACCEL
@@ -409,13 +615,15 @@ void mousekey_off(uint8_t code) {
 #    endif
 }
 
-#endif /* #ifndef MK_3_SPEED */
+#endif /* #ifdef MK_KINETIC */
 
 void mousekey_send(void) {
     mousekey_debug();
+#ifndef MK_KINETIC
     uint16_t time = timer_read();
     if (mouse_report.x || mouse_report.y) last_timer_c = time;
     if (mouse_report.v || mouse_report.h) last_timer_w = time;
+#endif
     host_mouse_send(&mouse_report);
 }
 
@@ -424,6 +632,10 @@ void mousekey_clear(void) {
     mousekey_repeat       = 0;
     mousekey_wheel_repeat = 0;
     mousekey_accel        = 0;
+#ifdef MK_KINETIC
+    memset(mk_dir, 0, sizeof(mk_dir));
+    memset(mk_accum, 0, sizeof(mk_accum));
+#endif
 }
 
 static void mousekey_debug(void) {
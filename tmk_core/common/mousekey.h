@@ -122,6 +122,59 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #endif /* #ifndef MK_3_SPEED */
 
+#ifdef MK_KINETIC
+
+#    ifdef MK_3_SPEED
+#        error MK_KINETIC and MK_3_SPEED cannot be used together
+#    endif
+
+#    define MK_CURVE_LINEAR 0
+#    define MK_CURVE_QUADRATIC 1
+#    define MK_CURVE_EXPONENTIAL 2
+
+/* milliseconds between movement updates */
+#    ifndef MK_KINETIC_FRAME
+#        define MK_KINETIC_FRAME 8
+#    endif
+/* longest time a single update integrates, so a stalled loop doesn't make the cursor jump */
+#    ifndef MK_KINETIC_MAX_STEP
+#        define MK_KINETIC_MAX_STEP 100
+#    endif
+/* cursor speeds in pixels per second */
+#    ifndef MK_KINETIC_INITIAL_SPEED
+#        define MK_KINETIC_INITIAL_SPEED 100
+#    endif
+#    ifndef MK_KINETIC_MAX_SPEED
+#        define MK_KINETIC_MAX_SPEED 1500
+#    endif
+#    ifndef MK_KINETIC_TIME_TO_MAX
+#        define MK_KINETIC_TIME_TO_MAX 1500
+#    endif
+/* wheel speeds in steps per second */
+#    ifndef MK_KINETIC_WHEEL_INITIAL_SPEED
+#        define MK_KINETIC_WHEEL_INITIAL_SPEED 8
+#    endif
+#    ifndef MK_KINETIC_WHEEL_MAX_SPEED
+#        define MK_KINETIC_WHEEL_MAX_SPEED 40
+#    endif
+#    ifndef MK_KINETIC_WHEEL_TIME_TO_MAX
+#        define MK_KINETIC_WHEEL_TIME_TO_MAX 1000
+#    endif
+#    ifndef MK_KINETIC_CURVE
+#        define MK_KINETIC_CURVE MK_CURVE_EXPONENTIAL
+#    endif
+/* the exponential curve is 2^(scale * t), scaled to the range, higher is slower at first */
+#    ifndef MK_KINETIC_CURVE_SCALE
+#        define MK_KINETIC_CURVE_SCALE 4
+#    elif MK_KINETIC_CURVE_SCALE < 1 || MK_KINETIC_CURVE_SCALE > 8
+#        error MK_KINETIC_CURVE_SCALE needs to be between 1 and 8
+#    endif
+#    if MK_KINETIC_MAX_SPEED > 16000 || MK_KINETIC_WHEEL_MAX_SPEED > 16000
+#        error MK_KINETIC_MAX_SPEED and MK_KINETIC_WHEEL_MAX_SPEED need to be at most 16000
+#    endif
+
+#endif /* #ifdef MK_KINETIC */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -110,7 +110,7 @@ enum desktop_usages {
 #        define KEYBOARD_REPORT_BITS (NKRO_EPSIZE - 1)
 #        undef NKRO_SHARED_EP
 #        undef MOUSE_SHARED_EP
-#    else
+#    elif !defined(KEYBOARD_REPORT_BITS)
 #        error "NKRO not supported with this protocol"
 #    endif
 #endif
@@ -245,7 +245,16 @@ int main(void) {
         }
 #endif
 
+#ifdef USB_SOF_SYNC
+        usb_sof_sync_wait();
+#endif
         keyboard_task();
+#ifdef USB_SOF_SYNC
+        usb_sof_sync_scanned();
+#endif
+#ifdef USB_REPORT_ACCUMULATE
+        usb_report_task();
+#endif
 #ifdef CONSOLE_ENABLE
         console_task();
 #endif
@@ -25,6 +25,8 @@
  *   makes the assumption this is safe to avoid littering with preprocessor directives.
  */
 
+#include <string.h>
+
 #include "ch.h"
 #include "hal.h"
 
@@ -70,13 +72,60 @@ uint8_t                keyboard_led_state                            = 0;
 volatile uint16_t      keyboard_idle_count                           = 0;
 static virtual_timer_t keyboard_idle_timer;
 static void            keyboard_idle_timer_cb(void *arg);
+#ifdef USB_SOF_SYNC
+static virtual_timer_t usb_sof_sync_timer;
+#endif
 
 report_keyboard_t keyboard_report_sent = {{0}};
+#ifdef USB_KEYBOARD_NONBLOCKING
+#    ifndef USB_KEYBOARD_QUEUE_SIZE
+#        define USB_KEYBOARD_QUEUE_SIZE 4
+#    endif
+/* report being transmitted, reports are copied here as the caller's may change before the transfer completes */
+static report_keyboard_t kbd_report_tx;
+/* reports waiting for the endpoint, send_keyboard() waits for room rather than drop a change the host hasn't seen */
+static report_keyboard_t kbd_report_queue[USB_KEYBOARD_QUEUE_SIZE];
+static uint8_t           kbd_report_head  = 0;
+static uint8_t           kbd_report_count = 0;
+
+/* whether the queued reports are in the NKRO layout, they keep it across an NKRO toggle */
+static bool kbd_report_queue_nkro = false;
+#endif
 #ifdef MOUSE_ENABLE
 report_mouse_t mouse_report_blank = {0};
+#    ifdef USB_REPORT_ACCUMULATE
+#        ifndef USB_MOUSE_QUEUE_SIZE
+#            define USB_MOUSE_QUEUE_SIZE 4
+#        endif
+/* mouse state waiting for the endpoint, motion is summed into the last entry until the buttons change */
+typedef struct {
+    uint8_t buttons;
+    int16_t x;
+    int16_t y;
+    int16_t v;
+    int16_t h;
+} mouse_accum_t;
+static report_mouse_t mouse_report_tx;
+static mouse_accum_t  mouse_queue[USB_MOUSE_QUEUE_SIZE];
+static uint8_t        mouse_queue_head  = 0;
+static uint8_t        mouse_queue_count = 0;
+#    endif
 #endif /* MOUSE_ENABLE */
 #ifdef EXTRAKEY_ENABLE
 uint8_t extra_report_blank[3] = {0};
+#    ifdef USB_REPORT_ACCUMULATE
+#        ifndef USB_EXTRA_QUEUE_SIZE
+#            define USB_EXTRA_QUEUE_SIZE 4
+#        endif
+#        if USB_EXTRA_QUEUE_SIZE < 3
+#            error "USB_EXTRA_QUEUE_SIZE must be at least 3 to always hold the latest system and consumer usages"
+#        endif
+static report_extra_t extra_report_tx;
+/* system and consumer usage changes waiting for the endpoint, in the order they happened */
+static report_extra_t extra_queue[USB_EXTRA_QUEUE_SIZE];
+static uint8_t        extra_queue_head  = 0;
+static uint8_t        extra_queue_count = 0;
+#    endif
 #endif /* EXTRAKEY_ENABLE */
 
 /* ---------------------------------------------------------
@@ -334,6 +383,19 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
                 }
                 qmkusbConfigureHookI(&drivers.array[i].driver);
             }
+#ifdef USB_KEYBOARD_NONBLOCKING
+            /* drop reports queued for the previous configuration */
+            kbd_report_count = 0;
+#endif
+#ifdef USB_REPORT_ACCUMULATE
+#    ifdef MOUSE_ENABLE
+            mouse_queue_count = 0;
+            mouse_report_tx   = mouse_report_blank;
+#    endif
+#    ifdef EXTRAKEY_ENABLE
+            extra_queue_count = 0;
+#    endif
+#endif
             osalSysUnlockFromISR();
             return;
         case USB_EVENT_SUSPEND:
@@ -344,6 +406,7 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
         case USB_EVENT_UNCONFIGURED:
             /* Falls into.*/
         case USB_EVENT_RESET:
+            host_keyboard_report_lost();
             for (int i = 0; i < NUM_USB_DRIVERS; i++) {
                 chSysLockFromISR();
                 /* Disconnection event on suspend.*/
@@ -354,6 +417,7 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
 
         case USB_EVENT_WAKEUP:
             // TODO: from ISR! print("[W]");
+            host_keyboard_report_lost();
             for (int i = 0; i < NUM_USB_DRIVERS; i++) {
                 chSysLockFromISR();
                 /* Disconnection event on suspend.*/
@@ -476,6 +540,13 @@ static bool usb_request_hook_cb(USBDriver *usbp) {
                     case HID_SET_PROTOCOL:
                         if ((usbp->setup[4] == KEYBOARD_INTERFACE) && (usbp->setup[5] == 0)) { /* wIndex */
                             keyboard_protocol = ((usbp->setup[2]) != 0x00);                    /* LSB(wValue) */
+#ifdef USB_KEYBOARD_NONBLOCKING
+                            /* the host starts over in the new protocol, so drop reports queued for the old one */
+                            osalSysLockFromISR();
+                            kbd_report_count = 0;
+                            osalSysUnlockFromISR();
+                            host_keyboard_report_lost();
+#endif
 #ifdef NKRO_ENABLE
                             keymap_config.nkro = !!keyboard_protocol;
                             if (!keymap_config.nkro && keyboard_idle) {
@@ -572,25 +643,277 @@ void init_usb_driver(USBDriver *usbp) {
     usbConnectBus(usbp);
 
     chVTObjectInit(&keyboard_idle_timer);
+#ifdef USB_SOF_SYNC
+    chVTObjectInit(&usb_sof_sync_timer);
+#endif
 }
 
 /* ---------------------------------------------------------
  *                  Keyboard functions
  * ---------------------------------------------------------
  */
+#if defined(USB_KEYBOARD_NONBLOCKING) || defined(USB_LATENCY_MEASURE)
+/* whether keyboard reports are currently built in the NKRO layout */
+static bool kbd_report_nkro(void) {
+#    ifdef NKRO_ENABLE
+    return keymap_config.nkro && keyboard_protocol;
+#    else
+    return false;
+#    endif
+}
+
+/* endpoint keyboard reports in the given layout are sent on */
+static usbep_t kbd_report_layout_ep(bool nkro) {
+#    ifdef NKRO_ENABLE
+    if (nkro) {
+        return SHARED_IN_EPNUM;
+    }
+#    else
+    (void)nkro;
+#    endif
+    return KEYBOARD_IN_EPNUM;
+}
+
+/* endpoint keyboard reports are currently sent on */
+static usbep_t kbd_report_ep(void) { return kbd_report_layout_ep(kbd_report_nkro()); }
+#endif
+
+#ifdef USB_LATENCY_MEASURE
+static usb_latency_t usb_latency;
+static systime_t     usb_latency_sof;
+static systime_t     usb_latency_submit;
+static bool          usb_latency_pending = false;
+
+static void usb_latency_add(usb_latency_stat_t *stat, systime_t start, systime_t end) {
+    uint32_t us = TIME_I2US(chTimeDiffX(start, end));
+    stat->count++;
+    stat->total_us += us;
+    if (us > stat->max_us) {
+        stat->max_us = us;
+    }
+}
+
+/* timestamp a keyboard report against the last SOF, unless one is already being timed
+ * callable from ISR or locked state */
+static void usb_latency_submit_i(void) {
+    if (!usb_latency_pending) {
+        usb_latency_submit  = chVTGetSystemTimeX();
+        usb_latency_pending = true;
+        usb_latency_add(&usb_latency.sof_to_submit, usb_latency_sof, usb_latency_submit);
+    }
+}
+
+void usb_latency_get(usb_latency_t *latency) {
+    osalSysLock();
+    *latency = usb_latency;
+    osalSysUnlock();
+}
+
+void usb_latency_reset(void) {
+    osalSysLock();
+    usb_latency         = (usb_latency_t){0};
+    usb_latency_pending = false;
+    osalSysUnlock();
+}
+#endif
+
+#ifdef USB_SOF_SYNC
+#    ifndef USB_SOF_SYNC_FRAME_US
+#        ifdef USB_HIGH_SPEED
+#            define USB_SOF_SYNC_FRAME_US 125
+#        else
+#            define USB_SOF_SYNC_FRAME_US 1000
+#        endif
+#    endif
+#    ifndef USB_SOF_SYNC_MARGIN_US
+#        define USB_SOF_SYNC_MARGIN_US 100
+#    endif
+/* signalled once per frame, just before the host is expected to poll */
+static BSEMAPHORE_DECL(usb_sof_sync_sem, true);
+/* how long the scan takes, decays slowly after a peak so the lead stays stable */
+static uint32_t  usb_sof_sync_scan_us = 0;
+static systime_t usb_sof_sync_start;
+
+/* callback (called from ISR, unlocked state) */
+static void usb_sof_sync_timer_cb(void *arg) {
+    (void)arg;
+    osalSysLockFromISR();
+    chBSemSignalI(&usb_sof_sync_sem);
+    osalSysUnlockFromISR();
+}
+
+/* arm the scan for the end of the frame that just started
+ * callable from ISR or locked state */
+static void usb_sof_sync_frame_i(void) {
+    uint32_t      lead  = usb_sof_sync_scan_us + USB_SOF_SYNC_MARGIN_US;
+    sysinterval_t delay = lead < USB_SOF_SYNC_FRAME_US ? TIME_US2I(USB_SOF_SYNC_FRAME_US - lead) : 0;
+    if (delay == 0) {
+        chBSemSignalI(&usb_sof_sync_sem);
+    } else if (!chVTIsArmedI(&usb_sof_sync_timer)) {
+        chVTSetI(&usb_sof_sync_timer, delay, usb_sof_sync_timer_cb, NULL);
+    }
+}
+
+void usb_sof_sync_wait(void) {
+    /* without SOFs (not configured, suspended) fall back to free running after two frames */
+    chBSemWaitTimeout(&usb_sof_sync_sem, TIME_US2I(USB_SOF_SYNC_FRAME_US * 2) + 1);
+    usb_sof_sync_start = chVTGetSystemTimeX();
+}
+
+void usb_sof_sync_scanned(void) {
+    uint32_t us = TIME_I2US(chTimeDiffX(usb_sof_sync_start, chVTGetSystemTimeX()));
+    osalSysLock();
+    if (us > usb_sof_sync_scan_us) {
+        usb_sof_sync_scan_us = us;
+    } else {
+        usb_sof_sync_scan_us -= (usb_sof_sync_scan_us - us) >> 4;
+    }
+    osalSysUnlock();
+}
+#endif
+
+#ifdef USB_KEYBOARD_NONBLOCKING
+/* start sending a report IN, the endpoint must be idle
+ * callable from ISR or locked state */
+static void kbd_report_transmit_i(report_keyboard_t *report, bool nkro) {
+    kbd_report_tx = *report;
+#    ifdef NKRO_ENABLE
+    if (nkro) { /* NKRO protocol */
+        usbStartTransmitI(&USB_DRIVER, SHARED_IN_EPNUM, (uint8_t *)&kbd_report_tx, sizeof(struct nkro_report));
+    } else
+#    endif /* NKRO_ENABLE */
+    {      /* regular protocol */
+        uint8_t *data, size;
+        if (keyboard_protocol) {
+            data = (uint8_t *)&kbd_report_tx;
+            size = KEYBOARD_REPORT_SIZE;
+        } else { /* boot protocol */
+            data = &kbd_report_tx.mods;
+            size = 8;
+        }
+        usbStartTransmitI(&USB_DRIVER, KEYBOARD_IN_EPNUM, data, size);
+    }
+#    ifndef NKRO_ENABLE
+    (void)nkro;
+#    endif
+    keyboard_report_sent = *report;
+}
+
+/* whether next can replace last in the queue without the host losing a key event
+ * or seeing keys change in a different order: only releases of keys that were
+ * already held before last can be folded into it */
+static bool kbd_report_coalesce(report_keyboard_t *prev, report_keyboard_t *last, report_keyboard_t *next, bool nkro) {
+#    ifdef NKRO_ENABLE
+    if (nkro) {
+        if (next->nkro.mods != last->nkro.mods) {
+            return false;
+        }
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS; i++) {
+            uint8_t pressed  = next->nkro.bits[i] & ~last->nkro.bits[i];
+            uint8_t released = last->nkro.bits[i] & ~next->nkro.bits[i];
+            if (pressed || (released & ~prev->nkro.bits[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+#    else
+    (void)nkro;
+#    endif
+    if (next->mods != last->mods) {
+        return false;
+    }
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (next->keys[i] && !is_key_pressed(last, next->keys[i])) {
+            return false;
+        }
+        if (last->keys[i] && !is_key_pressed(next, last->keys[i]) && !is_key_pressed(prev, last->keys[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* queue a report for the IN callback to send, false if that would lose a change the host
+ * hasn't seen yet: the queue is full, or holds reports in the other layout
+ * callable from locked state */
+static bool kbd_report_queue_i(report_keyboard_t *report, bool nkro) {
+    if (kbd_report_count > 0) {
+        if (nkro != kbd_report_queue_nkro) {
+            return false;
+        }
+        report_keyboard_t *last = &kbd_report_queue[(kbd_report_head + kbd_report_count - 1) % USB_KEYBOARD_QUEUE_SIZE];
+        report_keyboard_t *prev = kbd_report_count > 1 ? &kbd_report_queue[(kbd_report_head + kbd_report_count - 2) % USB_KEYBOARD_QUEUE_SIZE] : &keyboard_report_sent;
+        if (kbd_report_coalesce(prev, last, report, nkro)) {
+            *last = *report;
+            return true;
+        }
+        if (kbd_report_count == USB_KEYBOARD_QUEUE_SIZE) {
+            return false;
+        }
+    }
+    kbd_report_queue[(kbd_report_head + kbd_report_count) % USB_KEYBOARD_QUEUE_SIZE] = *report;
+    kbd_report_count++;
+    kbd_report_queue_nkro = nkro;
+    return true;
+}
+
+/* send the next queued report once the endpoint it goes to is idle
+ * callable from ISR or locked state */
+static void kbd_report_dequeue_i(usbep_t ep) {
+    if (kbd_report_count == 0 || ep != kbd_report_layout_ep(kbd_report_queue_nkro) || usbGetTransmitStatusI(&USB_DRIVER, ep)) {
+        return;
+    }
+    kbd_report_transmit_i(&kbd_report_queue[kbd_report_head], kbd_report_queue_nkro);
+    kbd_report_head = (kbd_report_head + 1) % USB_KEYBOARD_QUEUE_SIZE;
+    kbd_report_count--;
+}
+#endif
+
+#if defined(USB_KEYBOARD_NONBLOCKING) || defined(USB_LATENCY_MEASURE)
+/* an IN transfer has completed on an endpoint that may carry keyboard reports
+ * callable from ISR or locked state */
+static void kbd_report_in_i(usbep_t ep) {
+#    ifdef USB_LATENCY_MEASURE
+    if (usb_latency_pending && ep == kbd_report_ep()) {
+        usb_latency_add(&usb_latency.submit_to_in, usb_latency_submit, chVTGetSystemTimeX());
+        usb_latency_pending = false;
+    }
+#    endif
+#    ifdef USB_KEYBOARD_NONBLOCKING
+    kbd_report_dequeue_i(ep);
+#    endif
+}
+#endif
+
 /* keyboard IN callback hander (a kbd report has made it IN) */
 #ifndef KEYBOARD_SHARED_EP
 void kbd_in_cb(USBDriver *usbp, usbep_t ep) {
-    /* STUB */
     (void)usbp;
+#    if defined(USB_KEYBOARD_NONBLOCKING) || defined(USB_LATENCY_MEASURE)
+    osalSysLockFromISR();
+    kbd_report_in_i(ep);
+    osalSysUnlockFromISR();
+#    else
     (void)ep;
+#    endif
 }
 #endif
 
 /* start-of-frame handler
  * TODO: i guess it would be better to re-implement using timers,
  *  so that this is not going to have to be checked every 1ms */
-void kbd_sof_cb(USBDriver *usbp) { (void)usbp; }
+void kbd_sof_cb(USBDriver *usbp) {
+    (void)usbp;
+#ifdef USB_LATENCY_MEASURE
+    usb_latency_sof = chVTGetSystemTimeX();
+#endif
+#ifdef USB_SOF_SYNC
+    osalSysLockFromISR();
+    usb_sof_sync_frame_i();
+    osalSysUnlockFromISR();
+#endif
+}
 
 /* Idle requests timer code
  * callback (called from ISR, unlocked state) */
@@ -632,9 +955,36 @@ uint8_t keyboard_leds(void) { return keyboard_led_state; }
 void send_keyboard(report_keyboard_t *report) {
     osalSysLock();
     if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
-        goto unlock;
+        goto lost;
     }
 
+#ifdef USB_LATENCY_MEASURE
+    usb_latency_submit_i();
+#endif
+
+#ifdef USB_KEYBOARD_NONBLOCKING
+    bool nkro = kbd_report_nkro();
+    for (;;) {
+        usbep_t queue_ep = kbd_report_layout_ep(kbd_report_queue_nkro);
+        /* start on the queue if its endpoint is idle, whatever left it so */
+        kbd_report_dequeue_i(queue_ep);
+        if (kbd_report_count == 0 && !usbGetTransmitStatusI(&USB_DRIVER, kbd_report_layout_ep(nkro))) {
+            kbd_report_transmit_i(report, nkro);
+            break;
+        }
+        /* don't wait for the endpoint, the IN callback sends whatever is queued */
+        if (kbd_report_queue_i(report, nkro)) {
+            break;
+        }
+        /* the queue can't take the report without losing a change, or still holds reports from
+         * before an NKRO toggle, so wait for it to move on as the blocking path does */
+        osalThreadSuspendS(&(&USB_DRIVER)->epc[queue_ep]->in_state->thread);
+        if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
+            goto lost;
+        }
+    }
+#else
+
 #ifdef NKRO_ENABLE
     if (keymap_config.nkro && keyboard_protocol) { /* NKRO protocol */
         /* need to wait until the previous packet has made it through */
@@ -651,7 +1001,7 @@ void send_keyboard(report_keyboard_t *report) {
 
             /* after osalThreadSuspendS returns USB status might have changed */
             if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
-                goto unlock;
+                goto lost;
             }
         }
         usbStartTransmitI(&USB_DRIVER, SHARED_IN_EPNUM, (uint8_t *)report, sizeof(struct nkro_report));
@@ -669,7 +1019,7 @@ void send_keyboard(report_keyboard_t *report) {
 
             /* after osalThreadSuspendS returns USB status might have changed */
             if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
-                goto unlock;
+                goto lost;
             }
         }
         uint8_t *data, size;
@@ -683,7 +1033,13 @@ void send_keyboard(report_keyboard_t *report) {
         usbStartTransmitI(&USB_DRIVER, KEYBOARD_IN_EPNUM, data, size);
     }
     keyboard_report_sent = *report;
+#endif /* USB_KEYBOARD_NONBLOCKING */
+
+    goto unlock;
 
+lost:
+    /* the report was dropped, so it mustn't be skipped as a repeat next time */
+    host_keyboard_report_lost();
 unlock:
     osalSysUnlock();
 }
@@ -695,14 +1051,104 @@ unlock:
 
 #ifdef MOUSE_ENABLE
 
+#    ifdef USB_REPORT_ACCUMULATE
+static void mouse_accum_add(int16_t *accum, int8_t delta) {
+    int16_t sum = *accum + delta;
+    /* saturate rather than wrap if the host stops reading for a long time */
+    if ((delta > 0 && sum < *accum) || (delta < 0 && sum > *accum)) {
+        return;
+    }
+    *accum = sum;
+}
+
+/* take as much of the accumulated motion as fits in one report */
+static int8_t mouse_accum_take(int16_t *accum) {
+    int16_t delta = *accum > 127 ? 127 : *accum < -127 ? -127 : *accum;
+    *accum -= delta;
+    return delta;
+}
+
+/* send the oldest queued mouse state, the endpoint must be idle
+ * callable from ISR or locked state */
+static void mouse_transmit_i(void) {
+    mouse_accum_t *m = &mouse_queue[mouse_queue_head];
+
+#        ifdef MOUSE_SHARED_EP
+    mouse_report_tx.report_id = REPORT_ID_MOUSE;
+#        endif
+    mouse_report_tx.buttons = m->buttons;
+    mouse_report_tx.x       = mouse_accum_take(&m->x);
+    mouse_report_tx.y       = mouse_accum_take(&m->y);
+    mouse_report_tx.v       = mouse_accum_take(&m->v);
+    mouse_report_tx.h       = mouse_accum_take(&m->h);
+    if (!m->x && !m->y && !m->v && !m->h) {
+        mouse_queue_head = (mouse_queue_head + 1) % USB_MOUSE_QUEUE_SIZE;
+        mouse_queue_count--;
+    }
+    usbStartTransmitI(&USB_DRIVER, MOUSE_IN_EPNUM, (uint8_t *)&mouse_report_tx, sizeof(report_mouse_t));
+}
+
+/* add a report to the queue, merging its motion into the last entry when the buttons match
+ * callable from ISR or locked state */
+static void mouse_queue_i(report_mouse_t *report) {
+    mouse_accum_t *m;
+
+    if (mouse_queue_count > 0) {
+        m = &mouse_queue[(mouse_queue_head + mouse_queue_count - 1) % USB_MOUSE_QUEUE_SIZE];
+        if (m->buttons == report->buttons || mouse_queue_count == USB_MOUSE_QUEUE_SIZE) {
+            m->buttons = report->buttons;
+            mouse_accum_add(&m->x, report->x);
+            mouse_accum_add(&m->y, report->y);
+            mouse_accum_add(&m->v, report->v);
+            mouse_accum_add(&m->h, report->h);
+            return;
+        }
+    } else if (!report->x && !report->y && !report->v && !report->h && report->buttons == mouse_report_tx.buttons) {
+        /* nothing the host doesn't already have */
+        return;
+    }
+
+    m          = &mouse_queue[(mouse_queue_head + mouse_queue_count) % USB_MOUSE_QUEUE_SIZE];
+    m->buttons = report->buttons;
+    m->x       = report->x;
+    m->y       = report->y;
+    m->v       = report->v;
+    m->h       = report->h;
+    mouse_queue_count++;
+}
+#    endif
+
 #    ifndef MOUSE_SHARED_EP
 /* mouse IN callback hander (a mouse report has made it IN) */
 void mouse_in_cb(USBDriver *usbp, usbep_t ep) {
     (void)usbp;
     (void)ep;
+#        ifdef USB_REPORT_ACCUMULATE
+    /* the endpoint is only used by the mouse, so keep it busy while there is motion */
+    osalSysLockFromISR();
+    if (mouse_queue_count > 0) {
+        mouse_transmit_i();
+    }
+    osalSysUnlockFromISR();
+#        endif
 }
 #    endif
 
+#    ifdef USB_REPORT_ACCUMULATE
+void send_mouse(report_mouse_t *report) {
+    osalSysLock();
+    if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
+        osalSysUnlock();
+        return;
+    }
+
+    mouse_queue_i(report);
+    if (mouse_queue_count > 0 && !usbGetTransmitStatusI(&USB_DRIVER, MOUSE_IN_EPNUM)) {
+        mouse_transmit_i();
+    }
+    osalSysUnlock();
+}
+#    else
 void send_mouse(report_mouse_t *report) {
     osalSysLock();
     if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
@@ -723,6 +1169,7 @@ void send_mouse(report_mouse_t *report) {
     usbStartTransmitI(&USB_DRIVER, MOUSE_IN_EPNUM, (uint8_t *)report, sizeof(report_mouse_t));
     osalSysUnlock();
 }
+#    endif
 
 #else  /* MOUSE_ENABLE */
 void send_mouse(report_mouse_t *report) { (void)report; }
@@ -735,9 +1182,14 @@ void send_mouse(report_mouse_t *report) { (void)report; }
 #ifdef SHARED_EP_ENABLE
 /* shared IN callback hander */
 void shared_in_cb(USBDriver *usbp, usbep_t ep) {
-    /* STUB */
     (void)usbp;
+#    if defined(USB_KEYBOARD_NONBLOCKING) || defined(USB_LATENCY_MEASURE)
+    osalSysLockFromISR();
+    kbd_report_in_i(ep);
+    osalSysUnlockFromISR();
+#    else
     (void)ep;
+#    endif
 }
 #endif
 
@@ -747,6 +1199,61 @@ void shared_in_cb(USBDriver *usbp, usbep_t ep) {
  */
 
 #ifdef EXTRAKEY_ENABLE
+#    ifdef USB_REPORT_ACCUMULATE
+/* send the oldest queued usage change, the endpoint must be idle
+ * callable from ISR or locked state */
+static void extra_transmit_i(void) {
+    extra_report_tx   = extra_queue[extra_queue_head];
+    extra_queue_head  = (extra_queue_head + 1) % USB_EXTRA_QUEUE_SIZE;
+    extra_queue_count--;
+    usbStartTransmitI(&USB_DRIVER, SHARED_IN_EPNUM, (uint8_t *)&extra_report_tx, sizeof(report_extra_t));
+}
+
+/* the queued usage change i entries after the oldest */
+static report_extra_t *extra_queue_at(uint8_t i) { return &extra_queue[(extra_queue_head + i) % USB_EXTRA_QUEUE_SIZE]; }
+
+/* whether a later queued change of the same report makes entry i obsolete */
+static bool extra_queue_overridden(uint8_t i) {
+    for (uint8_t j = i + 1; j < extra_queue_count; j++) {
+        if (extra_queue_at(j)->report_id == extra_queue_at(i)->report_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* add a usage change to the queue, so a press followed by a release both reach the host
+ * callable from ISR or locked state */
+static void extra_queue_i(uint8_t report_id, uint16_t usage) {
+    if (extra_queue_count == USB_EXTRA_QUEUE_SIZE) {
+        /* drop the oldest obsolete change, there always is one as only two reports share the queue */
+        uint8_t i = 0;
+        while (!extra_queue_overridden(i)) {
+            i++;
+        }
+        for (; i < extra_queue_count - 1; i++) {
+            *extra_queue_at(i) = *extra_queue_at(i + 1);
+        }
+        extra_queue_count--;
+    }
+    *extra_queue_at(extra_queue_count) = (report_extra_t){.report_id = report_id, .usage = usage};
+    extra_queue_count++;
+}
+
+static void send_extra(uint8_t report_id, uint16_t data) {
+    osalSysLock();
+    if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
+        osalSysUnlock();
+        return;
+    }
+
+    extra_queue_i(report_id, data);
+    if (!usbGetTransmitStatusI(&USB_DRIVER, SHARED_IN_EPNUM)) {
+        extra_transmit_i();
+    }
+    osalSysUnlock();
+}
+#    else
 static void send_extra(uint8_t report_id, uint16_t data) {
     osalSysLock();
     if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
@@ -759,6 +1266,7 @@ static void send_extra(uint8_t report_id, uint16_t data) {
     usbStartTransmitI(&USB_DRIVER, SHARED_IN_EPNUM, (uint8_t *)&report, sizeof(report_extra_t));
     osalSysUnlock();
 }
+#    endif
 #endif
 
 void send_system(uint16_t data) {
@@ -773,6 +1281,26 @@ void send_consumer(uint16_t data) {
 #endif
 }
 
+#ifdef USB_REPORT_ACCUMULATE
+/* send what accumulated while an endpoint was busy, the shared endpoint has no callback of its own to do it */
+void usb_report_task(void) {
+    osalSysLock();
+    if (usbGetDriverStateI(&USB_DRIVER) == USB_ACTIVE) {
+#    ifdef MOUSE_ENABLE
+        if (mouse_queue_count > 0 && !usbGetTransmitStatusI(&USB_DRIVER, MOUSE_IN_EPNUM)) {
+            mouse_transmit_i();
+        }
+#    endif
+#    ifdef EXTRAKEY_ENABLE
+        if (extra_queue_count > 0 && !usbGetTransmitStatusI(&USB_DRIVER, SHARED_IN_EPNUM)) {
+            extra_transmit_i();
+        }
+#    endif
+    }
+    osalSysUnlock();
+}
+#endif
+
 /* ---------------------------------------------------------
  *                   Console functions
  * ---------------------------------------------------------
@@ -780,11 +1308,57 @@ void send_consumer(uint16_t data) {
 
 #ifdef CONSOLE_ENABLE
 
+#    ifdef USB_OUTPUT_NONBLOCKING
+#        ifndef CONSOLE_OUTPUT_BUFFER_SIZE
+#            define CONSOLE_OUTPUT_BUFFER_SIZE 512
+#        endif
+#        if (CONSOLE_OUTPUT_BUFFER_SIZE & (CONSOLE_OUTPUT_BUFFER_SIZE - 1)) != 0
+#            error "CONSOLE_OUTPUT_BUFFER_SIZE must be a power of two"
+#        endif
+/* single producer (sendchar), single consumer (console_task) ring, the indices run freely and wrap */
+static uint8_t           console_output_buffer[CONSOLE_OUTPUT_BUFFER_SIZE];
+static volatile uint16_t console_output_head    = 0;
+static volatile uint16_t console_output_tail    = 0;
+static volatile uint32_t console_output_dropped = 0;
+
+int8_t sendchar(uint8_t c) {
+    uint16_t head = console_output_head;
+    if ((uint16_t)(head - console_output_tail) >= CONSOLE_OUTPUT_BUFFER_SIZE) {
+        console_output_dropped++;
+        return -1;
+    }
+    console_output_buffer[head & (CONSOLE_OUTPUT_BUFFER_SIZE - 1)] = c;
+    /* the byte must be in place before the consumer can see it */
+    __asm__ volatile("" ::: "memory");
+    console_output_head = head + 1;
+    return 0;
+}
+
+uint32_t console_get_dropped(void) { return console_output_dropped; }
+
+/* move as much of the ring as the USB output queue can take without waiting */
+static void console_output_drain(void) {
+    uint16_t tail = console_output_tail;
+    uint16_t used = console_output_head - tail;
+    while (used > 0) {
+        uint16_t offset = tail & (CONSOLE_OUTPUT_BUFFER_SIZE - 1);
+        uint16_t chunk  = used < CONSOLE_OUTPUT_BUFFER_SIZE - offset ? used : CONSOLE_OUTPUT_BUFFER_SIZE - offset;
+        size_t   sent   = chnWriteTimeout(&drivers.console_driver.driver, &console_output_buffer[offset], chunk, TIME_IMMEDIATE);
+        tail += sent;
+        used -= sent;
+        if (sent < chunk) {
+            break;
+        }
+    }
+    console_output_tail = tail;
+}
+#    else
 int8_t sendchar(uint8_t c) {
     // The previous implmentation had timeouts, but I think it's better to just slow down
     // and make sure that everything is transferred, rather than dropping stuff
     return chnWrite(&drivers.console_driver.driver, &c, 1);
 }
+#    endif
 
 // Just a dummy function for now, this could be exposed as a weak function
 // Or connected to the actual QMK console
@@ -794,6 +1368,9 @@ static void console_receive(uint8_t *data, uint8_t length) {
 }
 
 void console_task(void) {
+#    ifdef USB_OUTPUT_NONBLOCKING
+    console_output_drain();
+#    endif
     uint8_t buffer[CONSOLE_EPSIZE];
     size_t  size = 0;
     do {
@@ -814,6 +1391,58 @@ int8_t sendchar(uint8_t c) {
 void _putchar(char character) { sendchar(character); }
 
 #ifdef RAW_ENABLE
+#    ifdef USB_OUTPUT_NONBLOCKING
+#        ifndef RAW_HID_OUTPUT_QUEUE_SIZE
+#            define RAW_HID_OUTPUT_QUEUE_SIZE 4
+#        endif
+#        if (RAW_HID_OUTPUT_QUEUE_SIZE & (RAW_HID_OUTPUT_QUEUE_SIZE - 1)) != 0
+#            error "RAW_HID_OUTPUT_QUEUE_SIZE must be a power of two"
+#        endif
+/* single producer (raw_hid_send), single consumer (raw_hid_task) ring of whole packets */
+static uint8_t           raw_hid_output_queue[RAW_HID_OUTPUT_QUEUE_SIZE][RAW_EPSIZE];
+static volatile uint8_t  raw_hid_output_head    = 0;
+static volatile uint8_t  raw_hid_output_tail    = 0;
+static volatile uint32_t raw_hid_output_dropped = 0;
+/* how much of the packet at the tail the USB output queue has already taken */
+static uint8_t raw_hid_output_offset = 0;
+
+void raw_hid_send(uint8_t *data, uint8_t length) {
+    // TODO: implement variable size packet
+    if (length != RAW_EPSIZE) {
+        return;
+    }
+    uint8_t head = raw_hid_output_head;
+    if ((uint8_t)(head - raw_hid_output_tail) >= RAW_HID_OUTPUT_QUEUE_SIZE) {
+        raw_hid_output_dropped++;
+        return;
+    }
+    memcpy(raw_hid_output_queue[head & (RAW_HID_OUTPUT_QUEUE_SIZE - 1)], data, RAW_EPSIZE);
+    /* the packet must be in place before the consumer can see it */
+    __asm__ volatile("" ::: "memory");
+    raw_hid_output_head = head + 1;
+}
+
+uint32_t raw_hid_get_dropped(void) { return raw_hid_output_dropped; }
+
+uint8_t raw_hid_send_space(void) { return RAW_HID_OUTPUT_QUEUE_SIZE - (uint8_t)(raw_hid_output_head - raw_hid_output_tail); }
+
+__attribute__((weak)) void raw_hid_send_ready(void) {}
+
+/* move as many queued packets as the USB output queue can take without waiting */
+static void raw_hid_output_drain(void) {
+    uint8_t tail = raw_hid_output_tail;
+    while (tail != raw_hid_output_head) {
+        uint8_t *packet = raw_hid_output_queue[tail & (RAW_HID_OUTPUT_QUEUE_SIZE - 1)];
+        raw_hid_output_offset += chnWriteTimeout(&drivers.raw_driver.driver, packet + raw_hid_output_offset, RAW_EPSIZE - raw_hid_output_offset, TIME_IMMEDIATE);
+        if (raw_hid_output_offset < RAW_EPSIZE) {
+            break;
+        }
+        raw_hid_output_offset = 0;
+        tail++;
+    }
+    raw_hid_output_tail = tail;
+}
+#    else
 void raw_hid_send(uint8_t *data, uint8_t length) {
     // TODO: implement variable size packet
     if (length != RAW_EPSIZE) {
@@ -821,6 +1450,7 @@ void raw_hid_send(uint8_t *data, uint8_t length) {
     }
     chnWrite(&drivers.raw_driver.driver, data, length);
 }
+#    endif
 
 __attribute__((weak)) void raw_hid_receive(uint8_t *data, uint8_t length) {
     // Users should #include "raw_hid.h" in their own code
@@ -829,6 +1459,12 @@ __attribute__((weak)) void raw_hid_receive(uint8_t *data, uint8_t length) {
 }
 
 void raw_hid_task(void) {
+#    ifdef USB_OUTPUT_NONBLOCKING
+    raw_hid_output_drain();
+    if (raw_hid_send_space() > 0) {
+        raw_hid_send_ready();
+    }
+#    endif
     uint8_t buffer[RAW_EPSIZE];
     size_t  size = 0;
     do {
@@ -48,6 +48,30 @@ void kbd_in_cb(USBDriver *usbp, usbep_t ep);
 /* start-of-frame handler */
 void kbd_sof_cb(USBDriver *usbp);
 
+#ifdef USB_LATENCY_MEASURE
+typedef struct {
+    uint32_t count;
+    uint32_t total_us;
+    uint32_t max_us;
+} usb_latency_stat_t;
+
+typedef struct {
+    usb_latency_stat_t sof_to_submit; /* from the last SOF to a keyboard report being submitted */
+    usb_latency_stat_t submit_to_in;  /* from a keyboard report being submitted to the host reading it */
+} usb_latency_t;
+
+/* copy out the keyboard report timings in microseconds, with a resolution of one system tick (1 / CH_CFG_ST_FREQUENCY) */
+void usb_latency_get(usb_latency_t *latency);
+void usb_latency_reset(void);
+#endif
+
+#ifdef USB_SOF_SYNC
+/* block until the scan should start to be ready for the next poll */
+void usb_sof_sync_wait(void);
+/* the scan and report build are done, used to track how early to wake */
+void usb_sof_sync_scanned(void);
+#endif
+
 #ifdef NKRO_ENABLE
 /* nkro IN callback hander */
 void nkro_in_cb(USBDriver *usbp, usbep_t ep);
@@ -72,6 +96,11 @@ void mouse_in_cb(USBDriver *usbp, usbep_t ep);
 /* shared IN request callback handler */
 void shared_in_cb(USBDriver *usbp, usbep_t ep);
 
+#ifdef USB_REPORT_ACCUMULATE
+/* send mouse, system and consumer reports held back while their endpoint was busy */
+void usb_report_task(void);
+#endif
+
 /* --------------
  * Console header
  * --------------
@@ -85,6 +114,21 @@ int8_t sendchar(uint8_t c);
 /* Flush output (send everything immediately) */
 void console_flush_output(void);
 
+#    ifdef USB_OUTPUT_NONBLOCKING
+/* console bytes thrown away because the output buffer was full */
+uint32_t console_get_dropped(void);
+#    endif
+
 #endif /* CONSOLE_ENABLE */
 
+#if defined(RAW_ENABLE) && defined(USB_OUTPUT_NONBLOCKING)
+/* raw HID packets thrown away because the output queue was full */
+uint32_t raw_hid_get_dropped(void);
+/* how many more packets raw_hid_send() can queue right now */
+uint8_t raw_hid_send_space(void);
+/* called from raw_hid_task() while the output queue has room, so replies longer than
+ * the queue can be sent a few packets at a time */
+void raw_hid_send_ready(void);
+#endif
+
 #endif /* _USB_MAIN_H_ */
@@ -416,7 +416,10 @@ void EVENT_USB_Device_Disconnect(void) {
  *
  * FIXME: Needs doc
  */
-void EVENT_USB_Device_Reset(void) { print("[R]"); }
+void EVENT_USB_Device_Reset(void) {
+    print("[R]");
+    host_keyboard_report_lost();
+}
 
 /** \brief Event USB Device Connect
  *
@@ -424,6 +427,7 @@ void EVENT_USB_Device_Reset(void) { print("[R]"); }
  */
 void EVENT_USB_Device_Suspend() {
     print("[S]");
+    host_keyboard_report_lost();
 #ifdef SLEEP_LED_ENABLE
     sleep_led_enable();
 #endif
@@ -435,6 +439,7 @@ void EVENT_USB_Device_Suspend() {
  */
 void EVENT_USB_Device_WakeUp() {
     print("[W]");
+    host_keyboard_report_lost();
     suspend_wakeup_init();
 
 #ifdef SLEEP_LED_ENABLE
@@ -687,6 +692,8 @@ static void send_keyboard(report_keyboard_t *report) {
     }
 
     if (where != OUTPUT_USB && where != OUTPUT_USB_AND_BT) {
+        // With nothing connected the report goes nowhere
+        if (where == OUTPUT_NONE) host_keyboard_report_lost();
         return;
     }
 #endif
@@ -703,7 +710,10 @@ static void send_keyboard(report_keyboard_t *report) {
     Endpoint_SelectEndpoint(ep);
     /* Check if write ready for a polling interval around 10ms */
     while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
+    if (!Endpoint_IsReadWriteAllowed()) {
+        host_keyboard_report_lost();
+        return;
+    }
 
     /* If we're in Boot Protocol, don't send any report ID or other funky fields */
     if (!keyboard_protocol) {
@@ -13,6 +13,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "outputselect.h"
+#include "host.h"
 
 #if defined(PROTOCOL_LUFA)
 #    include "lufa.h"
@@ -31,6 +32,8 @@ uint8_t desired_output = OUTPUT_DEFAULT;
 void set_output(uint8_t output) {
     set_output_user(output);
     desired_output = output;
+    // The new output hasn't seen the keyboard's state
+    host_keyboard_report_lost();
 }
 
 /** \brief Set Output User
@@ -344,7 +344,11 @@ const USB_Descriptor_Device_t PROGMEM DeviceDescriptor = {
         .Size                   = sizeof(USB_Descriptor_Device_t),
         .Type                   = DTYPE_Device
     },
+#ifdef USB_HIGH_SPEED
+    .USBSpecification           = VERSION_BCD(2, 0, 0),
+#else
     .USBSpecification           = VERSION_BCD(1, 1, 0),
+#endif
     
 #if VIRTSER_ENABLE
     .Class                      = USB_CSCP_IADDeviceClass,
@@ -367,12 +371,71 @@ const USB_Descriptor_Device_t PROGMEM DeviceDescriptor = {
     .NumberOfConfigurations     = FIXED_NUM_CONFIGURATIONS
 };
 
+#ifdef USB_HIGH_SPEED
+/*
+ * Device qualifier descriptor, required of high speed capable devices
+ */
+const USB_Descriptor_DeviceQualifier_t PROGMEM DeviceQualifierDescriptor = {
+    .Header = {
+        .Size                   = sizeof(USB_Descriptor_DeviceQualifier_t),
+        .Type                   = DTYPE_DeviceQualifier
+    },
+    .USBSpecification           = VERSION_BCD(2, 0, 0),
+#    if VIRTSER_ENABLE
+    .Class                      = USB_CSCP_IADDeviceClass,
+    .SubClass                   = USB_CSCP_IADDeviceSubclass,
+    .Protocol                   = USB_CSCP_IADDeviceProtocol,
+#    else
+    .Class                      = USB_CSCP_NoDeviceClass,
+    .SubClass                   = USB_CSCP_NoDeviceSubclass,
+    .Protocol                   = USB_CSCP_NoDeviceProtocol,
+#    endif
+    .Endpoint0Size              = FIXED_CONTROL_ENDPOINT_SIZE,
+    .NumberOfConfigurations     = FIXED_NUM_CONFIGURATIONS,
+    .Reserved                   = 0
+};
+#endif
+
 #ifndef USB_MAX_POWER_CONSUMPTION
 #    define USB_MAX_POWER_CONSUMPTION 500
 #endif
 
-#ifndef USB_POLLING_INTERVAL_MS
-#    define USB_POLLING_INTERVAL_MS 10
+/*
+ * Endpoint polling intervals, in frames (1 ms) at full speed, or as the
+ * exponent of 2^(n-1) microframes (125 us) with USB_HIGH_SPEED.
+ * USB_POLLING_INTERVAL_MS still sets all of them at once, in milliseconds
+ * either way: at high speed it is rounded down to the nearest exponent.
+ */
+#if defined(USB_POLLING_INTERVAL_MS) && defined(USB_HIGH_SPEED)
+#    define USB_POLLING_INTERVAL_HS(ms) ((ms) >= 4096 ? 16 : (ms) >= 2048 ? 15 : (ms) >= 1024 ? 14 : (ms) >= 512 ? 13 : (ms) >= 256 ? 12 : (ms) >= 128 ? 11 : (ms) >= 64 ? 10 : (ms) >= 32 ? 9 : (ms) >= 16 ? 8 : (ms) >= 8 ? 7 : (ms) >= 4 ? 6 : (ms) >= 2 ? 5 : 4)
+#    define USB_DEFAULT_FAST_POLLING_INTERVAL USB_POLLING_INTERVAL_HS(USB_POLLING_INTERVAL_MS)
+#    define USB_DEFAULT_SLOW_POLLING_INTERVAL USB_POLLING_INTERVAL_HS(USB_POLLING_INTERVAL_MS)
+#elif defined(USB_POLLING_INTERVAL_MS)
+#    define USB_DEFAULT_FAST_POLLING_INTERVAL USB_POLLING_INTERVAL_MS
+#    define USB_DEFAULT_SLOW_POLLING_INTERVAL USB_POLLING_INTERVAL_MS
+#elif defined(USB_HIGH_SPEED)
+#    define USB_DEFAULT_FAST_POLLING_INTERVAL 1  // 125 us
+#    define USB_DEFAULT_SLOW_POLLING_INTERVAL 4  // 1 ms
+#else
+#    define USB_DEFAULT_FAST_POLLING_INTERVAL 1   // 1 ms
+#    define USB_DEFAULT_SLOW_POLLING_INTERVAL 10  // 10 ms
+#endif
+
+#ifndef USB_KEYBOARD_POLLING_INTERVAL
+#    define USB_KEYBOARD_POLLING_INTERVAL USB_DEFAULT_FAST_POLLING_INTERVAL
+#endif
+
+// Carries NKRO and, with KEYBOARD_SHARED_EP, the keyboard reports
+#ifndef USB_SHARED_POLLING_INTERVAL
+#    define USB_SHARED_POLLING_INTERVAL USB_DEFAULT_FAST_POLLING_INTERVAL
+#endif
+
+#ifndef USB_MOUSE_POLLING_INTERVAL
+#    define USB_MOUSE_POLLING_INTERVAL USB_DEFAULT_SLOW_POLLING_INTERVAL
+#endif
+
+#ifndef USB_JOYSTICK_POLLING_INTERVAL
+#    define USB_JOYSTICK_POLLING_INTERVAL USB_DEFAULT_SLOW_POLLING_INTERVAL
 #endif
 
 /*
@@ -427,7 +490,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_IN | KEYBOARD_IN_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = KEYBOARD_EPSIZE,
-        .PollingIntervalMS      = USB_POLLING_INTERVAL_MS
+        .PollingIntervalMS      = USB_KEYBOARD_POLLING_INTERVAL
     },
 #endif
 
@@ -517,7 +580,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_IN | MOUSE_IN_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = MOUSE_EPSIZE,
-        .PollingIntervalMS      = USB_POLLING_INTERVAL_MS
+        .PollingIntervalMS      = USB_MOUSE_POLLING_INTERVAL
     },
 #endif
 
@@ -562,7 +625,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_IN | SHARED_IN_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = SHARED_EPSIZE,
-        .PollingIntervalMS      = USB_POLLING_INTERVAL_MS
+        .PollingIntervalMS      = USB_SHARED_POLLING_INTERVAL
     },
 #endif
 
@@ -907,7 +970,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_IN | JOYSTICK_IN_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = JOYSTICK_EPSIZE,
-        .PollingIntervalMS      = USB_POLLING_INTERVAL_MS
+        .PollingIntervalMS      = USB_JOYSTICK_POLLING_INTERVAL
     }
 #endif
 };
@@ -977,6 +1040,13 @@ uint16_t get_usb_descriptor(const uint16_t wValue, const uint16_t wIndex, const
             Size    = sizeof(USB_Descriptor_Configuration_t);
 
             break;
+#ifdef USB_HIGH_SPEED
+        case DTYPE_DeviceQualifier:
+            Address = &DeviceQualifierDescriptor;
+            Size    = sizeof(USB_Descriptor_DeviceQualifier_t);
+
+            break;
+#endif
         case DTYPE_String:
             switch (DescriptorIndex) {
                 case 0x00:
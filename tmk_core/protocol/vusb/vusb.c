@@ -222,6 +222,7 @@ static void send_keyboard(report_keyboard_t *report) {
         kbuf_head       = next;
     } else {
         dprint("kbuf: full\n");
+        host_keyboard_report_lost();
     }
 
     // NOTE: send key strokes of Macro